@@ -0,0 +1,75 @@
+#include <ESPLooper.h>
+
+// Batched publish benchmark
+//
+// An ADC-style producer publishes samples in bursts. Each burst goes out as
+// sendBatch() calls of BATCH events. Batch size 1 is the same as calling
+// sendEvent() per sample: one queue operation and one dispatcher wake per
+// event. Larger batches share both across the whole burst.
+
+static constexpr int TOTAL_EVENTS = 32000;
+static constexpr int BATCH_SIZES[] = {1, 8, 64};
+static constexpr int MAX_BATCH = 64;
+
+static volatile uint32_t received = 0;
+
+void runBatchSize(int batch) {
+    static uint16_t samples[MAX_BATCH];
+    static ESPLooper::BatchEvent events[MAX_BATCH];
+
+    received = 0;
+    uint32_t wakeupsBefore = ESP_LOOPER.events().getStats().dispatcherWakeups;
+    uint32_t cycles = 0;
+    uint32_t start = micros();
+
+    int sent = 0;
+    while (sent < TOTAL_EVENTS) {
+        for (int i = 0; i < batch; i++) {
+            samples[i] = analogRead(34);
+            events[i] = {EVENT_ID("adc"), &samples[i], sizeof(samples[i]), true};
+        }
+
+        uint32_t t0 = ESP.getCycleCount();
+        size_t queued = ESP_LOOPER.sendBatch(events, batch);
+        cycles += ESP.getCycleCount() - t0;
+
+        sent += queued;
+        if (queued < (size_t)batch) {
+            vTaskDelay(1); // Pool or queue full - let the dispatcher catch up
+        }
+    }
+    while (received < (uint32_t)sent) {
+        vTaskDelay(1);
+    }
+
+    uint32_t elapsed = micros() - start;
+    Serial.printf("batch %2d: %7u events/s, %5u cycles/event, %5u wakeups\n",
+                  batch, (uint32_t)((uint64_t)sent * 1000000 / elapsed),
+                  cycles / sent,
+                  ESP_LOOPER.events().getStats().dispatcherWakeups - wakeupsBefore);
+}
+
+void setup() {
+    Serial.begin(115200);
+    delay(1000);
+
+    Serial.println("=== ESP-Looper Batched Publish Benchmark ===\n");
+
+    ESPLooper::LooperConfig config;
+    config.eventPoolSize = 2 * MAX_BATCH;
+    ESP_LOOPER.begin(config);
+
+    ESP_LOOPER.events().on(EVENT_ID("adc"), [](const ESPLooper::Event&) {
+        received = received + 1;
+    });
+
+    for (int batch : BATCH_SIZES) {
+        runBatchSize(batch);
+    }
+
+    Serial.println("\nDone.");
+}
+
+void loop() {
+    vTaskDelay(portMAX_DELAY);
+}
@@ -0,0 +1,91 @@
+#include <ESPLooper.h>
+#include <functional>
+
+// Cost of storing and calling a callback that captures 16 bytes
+//
+// std::function keeps only small targets (8 bytes on ESP32) inline and
+// heap-allocates the rest; InplaceFunction keeps up to LP_FUNCTION_CAPACITY
+// bytes (16 on ESP32) inline and rejects bigger captures at compile time. The sketch
+// counts operator new calls while copying each kind CALLBACKS times, then
+// times CALLS invocations through each kind and a plain function pointer.
+
+static constexpr int CALLBACKS = 100;
+static constexpr int CALLS = 100000;
+
+static volatile uint32_t heapAllocs = 0;
+
+void* operator new(size_t size) {
+    heapAllocs = heapAllocs + 1;
+    void* p = malloc(size);
+    if (!p) {
+        abort();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+struct Gain {
+    float scale, offset, low, high;
+};
+
+static volatile float sink = 0;
+
+static void rawCallback() { sink = sink + 1; }
+
+template <typename F>
+static void timeCalls(const char* label, const F& f) {
+    uint32_t start = micros();
+    for (int i = 0; i < CALLS; i++) {
+        f();
+    }
+    uint32_t elapsed = micros() - start;
+    Serial.printf("  %-16s %.1f ns/call\n", label, elapsed * 1000.0f / CALLS);
+}
+
+template <typename Fn>
+static void countCopies(const char* label, const Fn& f) {
+    static Fn copies[CALLBACKS];
+    uint32_t before = heapAllocs;
+    for (int i = 0; i < CALLBACKS; i++) {
+        copies[i] = f;
+    }
+    Serial.printf("  %-16s %u allocations for %d copies (%u bytes each)\n",
+                  label, heapAllocs - before, CALLBACKS, (unsigned)sizeof(Fn));
+}
+
+void setup() {
+    Serial.begin(115200);
+    delay(1000);
+
+    Serial.println("=== ESP-Looper Callback Overhead ===\n");
+
+    ESP_LOOPER.begin();
+
+    Gain gain = {2.0f, 0.5f, 0.0f, 100.0f};
+    auto lambda = [gain]() { sink = sink + gain.scale + gain.offset; };
+
+    Serial.printf("Capture: %u bytes, InplaceFunction capacity: %u bytes\n",
+                  (unsigned)sizeof(lambda), (unsigned)LP_FUNCTION_CAPACITY);
+
+    Serial.println("\nStoring:");
+    countCopies("std::function", std::function<void()>(lambda));
+    countCopies("InplaceFunction", ESPLooper::InplaceFunction<void()>(lambda));
+
+    Serial.println("\nCalling:");
+    std::function<void()> stdFunction = lambda;
+    ESPLooper::InplaceFunction<void()> inplace = lambda;
+    ESPLooper::FunctionRef<void()> ref = lambda;
+    void (*raw)() = rawCallback;
+    timeCalls("std::function", stdFunction);
+    timeCalls("InplaceFunction", inplace);
+    timeCalls("FunctionRef", ref);
+    timeCalls("function pointer", raw);
+
+    Serial.println("\nDone.");
+}
+
+void loop() {
+    vTaskDelay(portMAX_DELAY);
+}
@@ -0,0 +1,71 @@
+#include <ESPLooper.h>
+
+// Cross-core ping-pong over channels
+//
+// "pinger" on core 0 sends a counter to "ponger" on core 1, which sends it
+// straight back. Each side parks in LP_CHANNEL_SEND/RECV until the other
+// one moves, so a round trip is two wakeups and no polling. Reports round
+// trips per second and the average round-trip time. Flip USE_SPSC to
+// compare the single-producer channel with the general MPMC one.
+
+static constexpr bool USE_SPSC = true;
+static constexpr uint32_t RUN_MS = 5000;
+
+template <typename T, size_t N>
+using BenchChannel =
+    typename std::conditional<USE_SPSC, ESPLooper::SpscChannel<T, N>,
+                              ESPLooper::Channel<T, N>>::type;
+
+BenchChannel<uint32_t, 4> ping;
+BenchChannel<uint32_t, 4> pong;
+
+// Thread bodies resume by line, not by stack: keep values in globals
+static uint32_t sent = 0;
+static uint32_t echoed = 0;
+static uint32_t reply = 0;
+static volatile uint32_t roundTrips = 0;
+
+LP_THREAD_("pinger", {
+    while (true) {
+        LP_CHANNEL_SEND(ping, sent);
+        LP_CHANNEL_RECV(pong, reply);
+        sent = reply + 1;
+        roundTrips = roundTrips + 1;
+    }
+}, 4096, 1, 0);
+
+LP_THREAD_("ponger", {
+    while (true) {
+        LP_CHANNEL_RECV(ping, echoed);
+        LP_CHANNEL_SEND(pong, echoed);
+    }
+}, 4096, 1, 1);
+
+void setup() {
+    Serial.begin(115200);
+    delay(1000);
+
+    Serial.printf("=== ESP-Looper Channel Ping-Pong (%s) ===\n\n",
+                  USE_SPSC ? "SPSC" : "MPMC");
+
+    ESP_LOOPER.begin();
+
+    uint32_t startTrips = roundTrips;
+    uint32_t start = micros();
+    delay(RUN_MS);
+    uint32_t trips = roundTrips - startTrips;
+    uint32_t elapsed = micros() - start;
+
+    Serial.printf("Round trips: %u in %u ms (%.0f/s)\n", trips, elapsed / 1000,
+                  trips * 1e6f / elapsed);
+    Serial.printf("Average round trip: %.2f us\n",
+                  trips ? (float)elapsed / trips : 0.0f);
+    Serial.printf("Pinger wakeups: %u\n\n",
+                  ESP_LOOPER.getThread("pinger")->getWakeups());
+
+    Serial.println("Done.");
+}
+
+void loop() {
+    vTaskDelay(portMAX_DELAY);
+}
@@ -0,0 +1,116 @@
+#include <ESPLooper.h>
+
+// Coroutines vs LP_THREAD: memory per thread and switch cost
+//
+// Needs a C++20 core (arduino-esp32 3.x). Both phases run a ping-pong pair
+// on core 1 over SPSC channels: first two coroutines on the core-1
+// scheduler, then two LP_THREADs on the core-1 executor. Reports round
+// trips per second, the time per switch (a round trip is two) and how much
+// memory one coroutine frame takes next to a ThreadTask and its stack.
+
+#if !defined(__cpp_impl_coroutine)
+#error "coroutine_bench needs C++20 coroutines (arduino-esp32 3.x)"
+#endif
+
+static constexpr uint32_t RUN_MS = 3000;
+static constexpr uint32_t THREAD_STACK = 4096;
+
+ESPLooper::SpscChannel<uint32_t, 4> ping;
+ESPLooper::SpscChannel<uint32_t, 4> pong;
+
+// 0 = idle, 1 = coroutines, 2 = threads
+static volatile int phase = 0;
+static volatile uint32_t roundTrips = 0;
+
+ESPLooper::CoTask coPinger() {
+    uint32_t value = 0;
+    // Spawned before measure() starts the phase
+    while (phase != 1) {
+        co_await ESPLooper::delay(10);
+    }
+    while (phase == 1) {
+        co_await ping.send(value);
+        value = co_await pong.recv() + 1;
+        roundTrips = roundTrips + 1;
+    }
+    co_await ping.send(UINT32_MAX); // Let the ponger finish too
+}
+
+ESPLooper::CoTask coPonger() {
+    while (true) {
+        uint32_t value = co_await ping.recv();
+        if (value == UINT32_MAX) {
+            break;
+        }
+        co_await pong.send(value);
+    }
+}
+
+// Thread bodies resume by line, not by stack: keep values in globals
+static uint32_t sent = 0;
+static uint32_t reply = 0;
+static uint32_t echoed = 0;
+
+LP_THREAD_("pinger", {
+    LP_WAIT_POLL(phase == 2, 10);
+    while (true) {
+        LP_CHANNEL_SEND(ping, sent);
+        LP_CHANNEL_RECV(pong, reply);
+        sent = reply + 1;
+        roundTrips = roundTrips + 1;
+    }
+}, THREAD_STACK, 1, 1);
+
+LP_THREAD_("ponger", {
+    while (true) {
+        LP_CHANNEL_RECV(ping, echoed);
+        LP_CHANNEL_SEND(pong, echoed);
+    }
+}, THREAD_STACK, 1, 1);
+
+static void report(const char* name, uint32_t trips, uint32_t elapsed) {
+    Serial.printf("%-10s %8u round trips (%.0f/s), %.2f us per switch\n", name,
+                  trips, trips * 1e6f / elapsed,
+                  trips ? (float)elapsed / (trips * 2) : 0.0f);
+}
+
+static void measure(const char* name, int which) {
+    uint32_t startTrips = roundTrips;
+    uint32_t start = micros();
+    phase = which;
+    delay(RUN_MS);
+    phase = 0;
+    report(name, roundTrips - startTrips, micros() - start);
+}
+
+void setup() {
+    Serial.begin(115200);
+    delay(1000);
+
+    Serial.println("=== ESP-Looper Coroutine Benchmark ===\n");
+
+    ESPLooper::LooperConfig config;
+    config.threadMode = ESPLooper::ThreadMode::Executor;
+    config.coroutines = true;
+    ESP_LOOPER.begin(config);
+
+    ESPLooper::spawn(coPinger(), 1);
+    ESPLooper::spawn(coPonger(), 1);
+    measure("Coroutine", 1);
+    delay(100);
+    measure("LP_THREAD", 2);
+
+    ESPLooper::CoFrameArena::Stats frames = ESPLooper::CoFrameArena::getStats();
+    Serial.printf("\nCoroutine frame: %u bytes\n", (unsigned)frames.largestFrame);
+    Serial.printf("LP_THREAD:       %u bytes task + %u bytes stack "
+                  "(own-task mode)\n\n",
+                  (unsigned)sizeof(ESPLooper::ThreadTask),
+                  (unsigned)THREAD_STACK);
+
+    ESP_LOOPER.printStats();
+    Serial.println("Done.");
+}
+
+void loop() {
+    vTaskDelay(portMAX_DELAY);
+}
@@ -0,0 +1,69 @@
+#include <ESPLooper.h>
+
+// Send-to-callback latency benchmark: Poll vs Notify dispatcher
+//
+// Each sample carries its send timestamp; the listener measures how long the
+// event sat in the queue before the dispatcher delivered it. Idle wakeups are
+// counted over one second with no traffic at all.
+
+static constexpr int SAMPLES = 500;
+
+static volatile int received = 0;
+static uint32_t minUs, maxUs;
+static uint64_t totalUs;
+
+void runBenchmark(ESPLooper::DispatchMode mode, const char* label) {
+    auto& bus = ESP_LOOPER.events();
+    bus.setDispatchMode(mode);
+    vTaskDelay(pdMS_TO_TICKS(10));
+
+    received = 0;
+    minUs = UINT32_MAX;
+    maxUs = 0;
+    totalUs = 0;
+
+    for (int i = 0; i < SAMPLES; i++) {
+        // Randomize the send phase relative to the tick
+        delayMicroseconds(random(0, 1000));
+
+        uint32_t stamp = micros();
+        ESP_SEND_EVENT(EVENT_ID("bench"), &stamp, sizeof(stamp));
+
+        while (received <= i) {
+            vTaskDelay(1);
+        }
+    }
+
+    uint32_t before = bus.getStats().dispatcherWakeups;
+    vTaskDelay(pdMS_TO_TICKS(1000));
+    uint32_t idleWakeups = bus.getStats().dispatcherWakeups - before;
+
+    Serial.printf("%-7s latency min %4u us, avg %4u us, max %5u us, idle wakeups/s %u\n",
+                  label, minUs, (uint32_t)(totalUs / SAMPLES), maxUs, idleWakeups);
+}
+
+void setup() {
+    Serial.begin(115200);
+    delay(1000);
+
+    Serial.println("=== ESP-Looper Dispatch Latency Benchmark ===\n");
+
+    ESP_LOOPER.begin();
+
+    ESP_LISTENER("bench_sink", EVENT_ID("bench"), [](const ESPLooper::Event& evt) {
+        uint32_t latency = micros() - *(uint32_t*)evt.data;
+        if (latency < minUs) minUs = latency;
+        if (latency > maxUs) maxUs = latency;
+        totalUs += latency;
+        received = received + 1;
+    });
+
+    runBenchmark(ESPLooper::DispatchMode::Poll, "Poll");
+    runBenchmark(ESPLooper::DispatchMode::Notify, "Notify");
+
+    Serial.println("\nDone.");
+}
+
+void loop() {
+    vTaskDelay(portMAX_DELAY);
+}
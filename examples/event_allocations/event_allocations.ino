@@ -0,0 +1,84 @@
+#include <ESPLooper.h>
+
+// Heap allocations per event for typical payloads
+//
+// Payloads up to LP_EVENT_INLINE_SIZE bytes (24 by default) are copied into
+// the Event itself. The 64-byte blob still takes the heap path, which is what
+// every copied payload paid before inline storage: one new + one malloc.
+
+static constexpr int EVENTS = 1000;
+
+struct Vector3 {
+    float x, y, z;
+};
+
+struct Blob {
+    uint8_t bytes[64];
+};
+
+static volatile int received = 0;
+
+template <typename Send>
+void measure(const char* label, Send send) {
+    auto& bus = ESP_LOOPER.events();
+    auto before = bus.getStats();
+    received = 0;
+
+    uint32_t start = micros();
+    for (int i = 0; i < EVENTS; i++) {
+        while (!send()) {
+            vTaskDelay(1); // Queue full - let the dispatcher catch up
+        }
+    }
+    while (received < EVENTS) {
+        vTaskDelay(1);
+    }
+    uint32_t elapsed = micros() - start;
+
+    auto after = bus.getStats();
+    uint32_t allocs = (after.heapEventAllocs - before.heapEventAllocs) +
+                      (after.heapPayloadAllocs - before.heapPayloadAllocs);
+
+    Serial.printf("%-14s %.2f allocs/event (%u inline), %.1f us/event\n",
+                  label, (float)allocs / EVENTS,
+                  after.inlinePayloads - before.inlinePayloads,
+                  (float)elapsed / EVENTS);
+}
+
+void setup() {
+    Serial.begin(115200);
+    delay(1000);
+
+    Serial.println("=== ESP-Looper Event Allocation Benchmark ===");
+    Serial.printf("Inline payload limit: %u bytes\n\n",
+                  (unsigned)ESPLooper::Event::INLINE_SIZE);
+
+    ESP_LOOPER.begin();
+
+    ESP_LOOPER.events().onAny([](const ESPLooper::Event&) {
+        received = received + 1;
+    });
+
+    int value = 42;
+    Vector3 accel = {0.1f, 0.2f, 9.8f};
+    Blob blob = {};
+
+    measure("int", [&]() {
+        return ESP_SEND_EVENT(EVENT_ID("int"), &value, sizeof(value));
+    });
+    measure("float[3]", [&]() {
+        return ESP_SEND_EVENT(EVENT_ID("accel"), &accel, sizeof(accel));
+    });
+    measure("short string", [&]() {
+        return ESP_SEND_EVENT(EVENT_ID("text"), (void*)"status: ok", 11);
+    });
+    measure("64-byte blob", [&]() {
+        return ESP_SEND_EVENT(EVENT_ID("blob"), &blob, sizeof(blob));
+    });
+
+    Serial.println("\nDone.");
+}
+
+void loop() {
+    vTaskDelay(portMAX_DELAY);
+}
@@ -27,6 +27,22 @@ LP_TIMER(2000, []() {
     LP_SEND_EVENT("action", &counter);
 });
 
+// Thread that blocks on its inbox - no polling between events
+LP_THREAD_("inbox", {
+    LP_WAIT_EVENT();
+    int* value = (int*)LP_EVENT_DATA();
+    if (value) {
+        Serial.printf("[Inbox] Event received! Value: %d\n", *value);
+    }
+});
+
+// Timer that sends events to the inbox thread
+LP_TIMER(1500, []() {
+    static int counter = 1000;
+    counter++;
+    LP_PUSH_EVENT("inbox", &counter);
+});
+
 // Another thread with state management
 LP_THREAD_("worker", {
     switch (Looper.thisState()) {
@@ -0,0 +1,49 @@
+#include <ESPLooper.h>
+
+// Publishing events straight from an interrupt handler
+//
+// No helper task or semaphore: the ISR copies its payload into a
+// preallocated event slot and wakes the dispatcher directly.
+
+static constexpr uint8_t BUTTON_PIN = 0;
+
+struct ButtonPress {
+    uint32_t timestampUs;
+    uint8_t level;
+};
+
+void IRAM_ATTR onButton() {
+    ButtonPress press = {(uint32_t)esp_timer_get_time(), (uint8_t)digitalRead(BUTTON_PIN)};
+    LP_SEND_EVENT_ISR("button", &press);
+}
+
+LP_LISTENER_("button", [](const ESPLooper::Event& evt) {
+    const ButtonPress* press = (const ButtonPress*)evt.data;
+    uint32_t latency = (uint32_t)esp_timer_get_time() - press->timestampUs;
+    Serial.printf("[Core %d] Button level %d, ISR-to-listener %u us\n",
+                  xPortGetCoreID(), press->level, latency);
+});
+
+LP_TIMER(10000, []() {
+    Serial.printf("ISR events dropped: %u\n", ESP_LOOPER.events().getStats().isrDropped);
+});
+
+void setup() {
+    Serial.begin(115200);
+    delay(1000);
+
+    Serial.println("=== ESP-Looper ISR Events Example ===\n");
+
+    ESPLooper::LooperConfig config;
+    config.isrEventSlots = 16; // Enough for a burst of bounces
+    ESP_LOOPER.begin(config);
+
+    pinMode(BUTTON_PIN, INPUT_PULLUP);
+    attachInterrupt(digitalPinToInterrupt(BUTTON_PIN), onButton, CHANGE);
+
+    Serial.println("Press the BOOT button...\n");
+}
+
+void loop() {
+    vTaskDelay(portMAX_DELAY);
+}
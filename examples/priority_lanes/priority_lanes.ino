@@ -0,0 +1,73 @@
+#include <ESPLooper.h>
+
+// Priority lanes: an urgent fault event overtakes a telemetry burst
+//
+// Every round queues a burst of slow telemetry events on the Normal lane and
+// then one fault event. Sent on the Normal lane too, the fault waits behind
+// the whole burst; sent on the High lane it is dispatched next.
+
+static constexpr int BURST = 40;
+static constexpr int ROUNDS = 20;
+
+static volatile uint32_t faultLatencyUs = 0;
+static volatile bool faultSeen = false;
+
+LP_LISTENER_("telemetry", [](const ESPLooper::Event& evt) {
+    delayMicroseconds(200); // Slow consumer, e.g. logging to flash
+});
+
+LP_LISTENER_("fault", [](const ESPLooper::Event& evt) {
+    faultLatencyUs = micros() - *(uint32_t*)evt.data;
+    faultSeen = true;
+});
+
+void runRounds(ESPLooper::EventPriority faultPriority, const char* label) {
+    uint32_t worst = 0;
+    uint64_t total = 0;
+
+    for (int round = 0; round < ROUNDS; round++) {
+        faultSeen = false;
+
+        for (int i = 0; i < BURST; i++) {
+            ESP_LOOPER.sendEvent("telemetry", &i, sizeof(i), true);
+        }
+
+        uint32_t stamp = micros();
+        ESP_SEND_EVENT_PRIORITY(EVENT_ID("fault"), &stamp, sizeof(stamp), faultPriority);
+
+        while (!faultSeen) {
+            vTaskDelay(1);
+        }
+        worst = max(worst, (uint32_t)faultLatencyUs);
+        total += faultLatencyUs;
+
+        while (ESP_LOOPER.events().getQueuedEvents() > 0) {
+            vTaskDelay(1);
+        }
+    }
+
+    Serial.printf("Fault on %-6s lane: avg %5u us, worst %5u us\n",
+                  label, (unsigned)(total / ROUNDS), (unsigned)worst);
+}
+
+void setup() {
+    Serial.begin(115200);
+    delay(1000);
+
+    Serial.println("=== ESP-Looper Priority Lanes Example ===\n");
+
+    ESP_LOOPER.begin();
+
+    // Let the burst pile up before the dispatcher on core 1 sees it
+    vTaskPrioritySet(nullptr, 5);
+
+    runRounds(ESPLooper::EventPriority::Normal, "Normal");
+    runRounds(ESPLooper::EventPriority::High, "High");
+
+    vTaskPrioritySet(nullptr, 1);
+    ESP_LOOPER.printStats();
+}
+
+void loop() {
+    vTaskDelay(portMAX_DELAY);
+}
@@ -0,0 +1,84 @@
+#include <ESPLooper.h>
+
+// Timer churn with heap stacks vs static task stacks
+//
+// Each round starts TIMERS short-lived timers with 2-4 KB stacks, while
+// the application keeps a few odd-sized allocations alive in between, as a
+// network stack would. Then the timers are removed again. With heap stacks
+// the freed stacks leave holes between the long-lived allocations; build
+// once with USE_STATIC_STACKS = false and once with true and compare the
+// largest free block and the failed creations after ROUNDS rounds.
+// Static stacks need CONFIG_FREERTOS_THREAD_LOCAL_STORAGE_POINTERS >= 2;
+// with less, begin() logs a warning and the timers use the heap.
+
+static constexpr bool USE_STATIC_STACKS = true;
+static constexpr int TIMERS = 8;
+static constexpr int ROUNDS = 200;
+
+static constexpr uint32_t stackSizes[] = {2048, 3072, 4096};
+
+static void* kept[ROUNDS];
+
+void setup() {
+    Serial.begin(115200);
+    delay(1000);
+
+    Serial.printf("=== ESP-Looper Task Stack Churn (%s) ===\n\n",
+                  USE_STATIC_STACKS ? "static stacks" : "heap stacks");
+
+    ESPLooper::LooperConfig config;
+    if (USE_STATIC_STACKS) {
+        // Spare blocks for timers that are still finishing a callback on
+        // the other core when removed; FreeRTOS frees those a bit later
+        config.taskStacks[0] = {2048, TIMERS + 2};
+        config.taskStacks[1] = {4096, TIMERS + 2};
+        config.staticTasksOnly = true;
+    }
+    ESP_LOOPER.begin(config);
+
+    Serial.printf("Start: free %u, largest block %u\n",
+                  (unsigned)ESP.getFreeHeap(),
+                  (unsigned)heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+
+    static char names[TIMERS][8];
+    for (int i = 0; i < TIMERS; i++) {
+        snprintf(names[i], sizeof(names[i]), "t%d", i);
+    }
+
+    uint32_t failed = 0;
+    uint32_t createUs = 0;
+    for (int round = 0; round < ROUNDS; round++) {
+        for (int i = 0; i < TIMERS; i++) {
+            uint32_t start = micros();
+            auto timer = ESP_LOOPER.addTimer(names[i], []() {}, 10, true,
+                                             tskNO_AFFINITY,
+                                             stackSizes[(round + i) % 3]);
+            createUs += micros() - start;
+            if (!timer->getHandle()) {
+                failed++;
+            }
+
+            if (i == TIMERS / 2) {
+                kept[round] = malloc(48 + (round * 37) % 200);
+            }
+        }
+        delay(20);
+        for (int i = 0; i < TIMERS; i++) {
+            ESP_LOOPER.removeTask(names[i]);
+        }
+    }
+
+    Serial.printf("After %d rounds: free %u, largest block %u\n", ROUNDS,
+                  (unsigned)ESP.getFreeHeap(),
+                  (unsigned)heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+    Serial.printf("Failed creations: %u, %.1f us per addTimer\n\n",
+                  (unsigned)failed,
+                  (float)createUs / (ROUNDS * TIMERS));
+
+    ESP_LOOPER.printStats();
+    Serial.println("Done.");
+}
+
+void loop() {
+    vTaskDelay(portMAX_DELAY);
+}
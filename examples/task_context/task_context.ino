@@ -0,0 +1,92 @@
+#include <ESPLooper.h>
+
+// Cost of the state query methods with many registered tasks
+//
+// Registers TASK_COUNT idle timers, then a "probe" timer that times CALLS
+// calls of ESP_LOOPER.thisState(), eventData() and thisTaskName(), once in
+// its own loop and once while an event sent to it runs on the dispatcher.
+// The calls read the caller's thread-local context, so the cost doesn't
+// grow with the number of tasks. The probe also counts how often its loop
+// saw a state other than Loop while those events were being delivered.
+
+static constexpr int TASK_COUNT = 100;
+static constexpr int CALLS = 10000;
+
+static volatile uint32_t wrongState = 0;
+static volatile bool timerReported = false;
+static volatile bool eventReported = false;
+
+static void timeCalls(const char* where) {
+    volatile uint32_t sink = 0;
+
+    uint32_t start = micros();
+    for (int i = 0; i < CALLS; i++) {
+        sink = sink + (uint32_t)ESP_LOOPER.thisState();
+    }
+    uint32_t stateUs = micros() - start;
+
+    start = micros();
+    for (int i = 0; i < CALLS; i++) {
+        sink = sink + (uint32_t)(uintptr_t)ESP_LOOPER.eventData();
+    }
+    uint32_t dataUs = micros() - start;
+
+    start = micros();
+    for (int i = 0; i < CALLS; i++) {
+        sink = sink + (uint32_t)(uintptr_t)ESP_LOOPER.thisTaskName();
+    }
+    uint32_t nameUs = micros() - start;
+
+    Serial.printf("%-9s thisState %.3f us, eventData %.3f us, "
+                  "thisTaskName %.3f us (%s)\n",
+                  where, (float)stateUs / CALLS, (float)dataUs / CALLS,
+                  (float)nameUs / CALLS, ESP_LOOPER.thisTaskName());
+}
+
+void setup() {
+    Serial.begin(115200);
+    delay(1000);
+
+    Serial.printf("=== ESP-Looper Task Context Benchmark (%d tasks) ===\n\n",
+                  TASK_COUNT);
+
+    ESP_LOOPER.begin();
+
+    static char names[TASK_COUNT][12];
+    for (int i = 0; i < TASK_COUNT; i++) {
+        snprintf(names[i], sizeof(names[i]), "idle%d", i);
+        ESP_LOOPER.addTimer(names[i], []() {}, 1000, false);
+    }
+
+    ESP_LOOPER.addTimer("probe", []() {
+        if (ESP_LOOPER.thisState() == tState::Event) {
+            if (!eventReported) {
+                eventReported = true;
+                timeCalls("Event");
+            }
+            return;
+        }
+        if (ESP_LOOPER.thisState() != tState::Loop &&
+            ESP_LOOPER.thisState() != tState::Setup) {
+            wrongState = wrongState + 1;
+        }
+        if (!timerReported) {
+            timerReported = true;
+            timeCalls("Timer");
+        }
+    }, 1, true, 0);
+
+    // Events for "probe" run its callback on the dispatcher (core 1)
+    for (int i = 0; i < 20; i++) {
+        ESP_LOOPER.sendEvent("probe", &i, sizeof(i), true);
+        delay(50);
+    }
+
+    delay(100);
+    Serial.printf("\nTimer saw a foreign state %u times\n\n", wrongState);
+    Serial.println("Done.");
+}
+
+void loop() {
+    vTaskDelay(portMAX_DELAY);
+}
@@ -0,0 +1,62 @@
+#include <ESPLooper.h>
+
+// Add/remove cycles per second for short-lived timers
+//
+// Starts and removes a timer CYCLES times, like one timeout per network
+// request, and reports cycles per second and the heap left afterwards.
+// Build once with USE_RECYCLING = false (a new Task object and FreeRTOS
+// task per cycle) and once with true (parked workers and recycled Task
+// blocks) and compare. A second pass keeps LIVE timers running on both
+// cores while cycling.
+
+static constexpr bool USE_RECYCLING = true;
+static constexpr int CYCLES = 2000;
+static constexpr int LIVE = 6;
+
+static void cycle(const char* label) {
+    uint32_t heapBefore = ESP.getFreeHeap();
+    uint32_t start = micros();
+    for (int i = 0; i < CYCLES; i++) {
+        auto timer = ESP_LOOPER.addTimer("timeout", []() {}, 5000, true,
+                                         i % 2, 4096);
+        ESP_LOOPER.removeTask(timer);
+    }
+    uint32_t elapsed = micros() - start;
+
+    Serial.printf("%-12s %.0f cycles/s (%.1f us each), heap %+d bytes\n",
+                  label, CYCLES * 1e6f / elapsed, (float)elapsed / CYCLES,
+                  (int)ESP.getFreeHeap() - (int)heapBefore);
+}
+
+void setup() {
+    Serial.begin(115200);
+    delay(1000);
+
+    Serial.printf("=== ESP-Looper Task Recycling (%s) ===\n\n",
+                  USE_RECYCLING ? "recycling" : "create/delete");
+
+    ESPLooper::LooperConfig config;
+    if (USE_RECYCLING) {
+        config.parkedWorkers = 4;
+        config.recycledTasks = 4;
+    }
+    ESP_LOOPER.begin(config);
+
+    cycle("Idle");
+
+    static char names[LIVE][8];
+    for (int i = 0; i < LIVE; i++) {
+        snprintf(names[i], sizeof(names[i]), "live%d", i);
+        ESP_LOOPER.addTimer(names[i], []() { delayMicroseconds(200); }, 10,
+                            true, i % 2);
+    }
+    cycle("Busy");
+
+    Serial.println();
+    ESP_LOOPER.printStats();
+    Serial.println("Done.");
+}
+
+void loop() {
+    vTaskDelay(portMAX_DELAY);
+}
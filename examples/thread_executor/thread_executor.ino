@@ -0,0 +1,82 @@
+#include <ESPLooper.h>
+
+// Thread memory: one task per LP_THREAD vs the cooperative executor
+//
+// Creates THREAD_COUNT threads that each count in LP_DELAY steps and reports
+// the heap they cost. Build once with USE_EXECUTOR = false (one FreeRTOS
+// task and 8 KB stack per thread) and once with true (all threads stepped
+// on one Executor worker per core) and compare.
+
+static constexpr bool USE_EXECUTOR = true;
+static constexpr int THREAD_COUNT = 100;
+static constexpr uint32_t DELAY_MS = 10;
+static constexpr uint32_t RUN_MS = 5000;
+
+static std::shared_ptr<ESPLooper::ThreadTask> threads[THREAD_COUNT];
+static volatile uint32_t counts[THREAD_COUNT];
+
+void threadBody(int index) {
+    // The thread starts stepping before its handle is stored
+    auto _LP_THREAD_HANDLE = threads[index];
+    if (!_LP_THREAD_HANDLE) {
+        return;
+    }
+
+    LP_THREAD_BEGIN();
+    LP_DELAY(DELAY_MS);
+    counts[index] = counts[index] + 1;
+    LP_THREAD_END();
+}
+
+void setup() {
+    Serial.begin(115200);
+    delay(1000);
+
+    Serial.printf("=== ESP-Looper Thread Benchmark (%s) ===\n\n",
+                  USE_EXECUTOR ? "executor" : "task per thread");
+
+    ESPLooper::LooperConfig config;
+    config.threadMode = USE_EXECUTOR ? ESPLooper::ThreadMode::Executor
+                                     : ESPLooper::ThreadMode::Task;
+    ESP_LOOPER.begin(config);
+
+    uint32_t heapBefore = ESP.getFreeHeap();
+    int created = 0;
+    for (int i = 0; i < THREAD_COUNT; i++) {
+        char name[12];
+        snprintf(name, sizeof(name), "thread%d", i);
+        const char* id = strdup(name);
+
+        auto thread = std::make_shared<ESPLooper::ThreadTask>(
+            id, [i]() { threadBody(i); }, 8192, 1, i % 2);
+        if (!USE_EXECUTOR && !thread->getHandle()) {
+            Serial.printf("Out of memory after %d threads\n", created);
+            break;
+        }
+        threads[i] = thread;
+        ESP_LOOPER.addThread(id, thread);
+        created++;
+    }
+    uint32_t heapUsed = heapBefore - ESP.getFreeHeap();
+
+    delay(RUN_MS);
+
+    uint32_t total = 0;
+    for (int i = 0; i < created; i++) {
+        total += counts[i];
+    }
+
+    Serial.printf("Heap for %d threads: %u bytes (%u per thread)\n", created,
+                  (unsigned)heapUsed,
+                  created ? (unsigned)(heapUsed / created) : 0u);
+    Serial.printf("Steps: %u total, %u per thread (ideal %u)\n\n",
+                  (unsigned)total, created ? (unsigned)(total / created) : 0u,
+                  (unsigned)(RUN_MS / DELAY_MS));
+
+    ESP_LOOPER.printStats();
+    Serial.println("Done.");
+}
+
+void loop() {
+    vTaskDelay(portMAX_DELAY);
+}
@@ -0,0 +1,122 @@
+#include <ESPLooper.h>
+
+// Idle thread cost: wakeups per second of threads that are only waiting
+//
+// Starts IDLE_THREADS threads, a quarter each sleeping in a long LP_DELAY,
+// parked in LP_WAIT on a flag nobody sets, parked in LP_SEM_WAIT and parked
+// in LP_CHANNEL_RECV, and counts how often their bodies run. With 1 ms
+// polling each of them ran ~1000 times a second. Now a delay sleeps until
+// its deadline, semaphore and channel waits until they are woken, and a
+// plain LP_WAIT re-checks every config.waitRecheckMs (100 ms by default,
+// ~10 wakeups a second). The last phase sets the flag, wakes the LP_WAIT
+// threads with LP_NOTIFY and measures how long the first one takes to
+// resume.
+
+static constexpr bool USE_EXECUTOR = false;
+static constexpr int IDLE_THREADS = 20;
+static constexpr uint32_t RUN_MS = 5000;
+
+enum WaitOn { OnDelay, OnWait, OnSem, OnChannel, WAIT_KINDS };
+static const char* const WAIT_NAMES[WAIT_KINDS] = {
+    "LP_DELAY", "LP_WAIT", "LP_SEM_WAIT", "LP_CHANNEL_RECV"};
+
+static std::shared_ptr<ESPLooper::ThreadTask> threads[IDLE_THREADS];
+static volatile bool ready = false;
+static volatile uint32_t resumedAt = 0;
+static LP_SEM idleSem;
+static LP_CHANNEL(int, 4) idleChannel;
+
+void threadBody(int index) {
+    // The thread starts stepping before its handle is stored
+    auto _LP_THREAD_HANDLE = threads[index];
+    if (!_LP_THREAD_HANDLE) {
+        return;
+    }
+
+    static int received[IDLE_THREADS];
+
+    // No switch here: it would capture the case labels of the LP_ macros
+    int kind = index % WAIT_KINDS;
+    LP_THREAD_BEGIN();
+    if (kind == OnDelay) {
+        LP_DELAY(60000);
+    } else if (kind == OnWait) {
+        LP_WAIT(ready);
+        if (!resumedAt) {
+            resumedAt = micros();
+        }
+        LP_WAIT(false);
+    } else if (kind == OnSem) {
+        LP_SEM_WAIT(idleSem);
+    } else {
+        LP_CHANNEL_RECV(idleChannel, received[index]);
+    }
+    LP_THREAD_END();
+}
+
+void setup() {
+    Serial.begin(115200);
+    delay(1000);
+
+    Serial.printf("=== ESP-Looper Idle Thread Benchmark (%s) ===\n\n",
+                  USE_EXECUTOR ? "executor" : "task per thread");
+
+    ESPLooper::LooperConfig config;
+    config.threadMode = USE_EXECUTOR ? ESPLooper::ThreadMode::Executor
+                                     : ESPLooper::ThreadMode::Task;
+    ESP_LOOPER.begin(config);
+    idleSem = LP_SEM_CREATE();
+
+    char name[12];
+    for (int i = 0; i < IDLE_THREADS; i++) {
+        snprintf(name, sizeof(name), "idle%d", i);
+        const char* id = strdup(name);
+        threads[i] = std::make_shared<ESPLooper::ThreadTask>(
+            id, [i]() { threadBody(i); }, 4096, 1, i % 2);
+        ESP_LOOPER.addThread(id, threads[i]);
+    }
+
+    // Let every thread reach its wait first
+    delay(100);
+    uint32_t before[IDLE_THREADS];
+    for (int i = 0; i < IDLE_THREADS; i++) {
+        before[i] = threads[i]->getWakeups();
+    }
+    delay(RUN_MS);
+
+    uint32_t perKind[WAIT_KINDS] = {};
+    uint32_t total = 0;
+    for (int i = 0; i < IDLE_THREADS; i++) {
+        uint32_t wakeups = threads[i]->getWakeups() - before[i];
+        perKind[i % WAIT_KINDS] += wakeups;
+        total += wakeups;
+    }
+
+    for (int kind = 0; kind < WAIT_KINDS; kind++) {
+        Serial.printf("%-16s %u wakeups in %u ms (%.1f/s per thread)\n",
+                      WAIT_NAMES[kind], perKind[kind], RUN_MS,
+                      perKind[kind] * 1000.0f / RUN_MS /
+                          (IDLE_THREADS / WAIT_KINDS));
+    }
+    Serial.printf("%d idle threads: %.1f wakeups/s (was ~%d/s with 1 ms "
+                  "polling)\n",
+                  IDLE_THREADS, total * 1000.0f / RUN_MS, IDLE_THREADS * 1000);
+
+    uint32_t start = micros();
+    ready = true;
+    for (int i = OnWait; i < IDLE_THREADS; i += WAIT_KINDS) {
+        snprintf(name, sizeof(name), "idle%d", i);
+        LP_NOTIFY(name);
+    }
+    while (!resumedAt) {
+        delay(1);
+    }
+    Serial.printf("Notify to resume: %u us\n\n", resumedAt - start);
+
+    ESP_LOOPER.printStats();
+    Serial.println("Done.");
+}
+
+void loop() {
+    vTaskDelay(portMAX_DELAY);
+}
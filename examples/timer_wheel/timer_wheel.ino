@@ -0,0 +1,79 @@
+#include <ESPLooper.h>
+
+// Timer memory and jitter: one task per timer vs the timing wheel
+//
+// Creates TIMER_COUNT periodic timers and reports the heap they cost and how
+// far each callback strays from its ideal period. Build once with
+// USE_WHEEL = false (one FreeRTOS task and stack per timer) and once with
+// true (all callbacks on the TimerService tasks) and compare.
+
+static constexpr bool USE_WHEEL = true;
+static constexpr int TIMER_COUNT = 40;
+static constexpr uint32_t PERIOD_MS = 20;
+static constexpr uint32_t RUN_MS = 5000;
+
+struct Sample {
+    uint32_t last;
+    uint32_t maxJitter;
+    uint64_t sumJitter;
+    uint32_t count;
+};
+static Sample samples[TIMER_COUNT];
+
+void onTimer(int index) {
+    uint32_t now = micros();
+    Sample& s = samples[index];
+    if (s.last) {
+        int32_t jitter = (int32_t)(now - s.last) - (int32_t)(PERIOD_MS * 1000);
+        uint32_t magnitude = jitter < 0 ? -jitter : jitter;
+        s.maxJitter = max(s.maxJitter, magnitude);
+        s.sumJitter += magnitude;
+        s.count++;
+    }
+    s.last = now;
+}
+
+void setup() {
+    Serial.begin(115200);
+    delay(1000);
+
+    Serial.printf("=== ESP-Looper Timer Benchmark (%s) ===\n\n",
+                  USE_WHEEL ? "timing wheel" : "task per timer");
+
+    ESPLooper::LooperConfig config;
+    config.timerMode = USE_WHEEL ? ESPLooper::TimerMode::Wheel
+                                 : ESPLooper::TimerMode::Task;
+    ESP_LOOPER.begin(config);
+
+    uint32_t heapBefore = ESP.getFreeHeap();
+    for (int i = 0; i < TIMER_COUNT; i++) {
+        char name[12];
+        snprintf(name, sizeof(name), "timer%d", i);
+        ESP_TIMER(strdup(name), PERIOD_MS, [i]() { onTimer(i); }, true, i % 2);
+    }
+    uint32_t heapUsed = heapBefore - ESP.getFreeHeap();
+
+    delay(RUN_MS);
+
+    uint32_t worst = 0;
+    uint64_t sum = 0;
+    uint32_t count = 0;
+    for (const Sample& s : samples) {
+        worst = max(worst, s.maxJitter);
+        sum += s.sumJitter;
+        count += s.count;
+    }
+
+    Serial.printf("Heap for %d timers: %u bytes (%u per timer)\n", TIMER_COUNT,
+                  (unsigned)heapUsed, (unsigned)(heapUsed / TIMER_COUNT));
+    Serial.printf("Jitter: avg %u us, worst %u us over %u callbacks\n\n",
+                  count ? (unsigned)(sum / count) : 0u, (unsigned)worst,
+                  (unsigned)count);
+
+    ESP_LOOPER.printStats();
+    Serial.println("Done.");
+}
+
+void loop() {
+    vTaskDelay(portMAX_DELAY);
+}
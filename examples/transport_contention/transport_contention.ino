@@ -0,0 +1,95 @@
+#include <ESPLooper.h>
+
+// EventBus transport contention benchmark: FreeRTOS queue vs lock-free ring
+//
+// Sweeps the number of producer tasks, alternating them between core 0 and
+// core 1, and reports delivered events/s and the average cost of one send().
+// Events come from a preallocated pool so the numbers isolate the transport
+// rather than the heap.
+
+static constexpr int EVENTS_PER_PRODUCER = 2000;
+static constexpr int PRODUCER_COUNTS[] = {1, 2, 4, 6, 8};
+
+static volatile uint32_t received = 0;
+static volatile uint32_t sendCycles = 0;
+static volatile int producersDone = 0;
+static SemaphoreHandle_t statsMutex;
+
+void producer(void*) {
+    uint32_t cycles = 0;
+    int sent = 0;
+
+    while (sent < EVENTS_PER_PRODUCER) {
+        uint32_t start = ESP.getCycleCount();
+        bool ok = ESP_LOOPER.sendEvent(EVENT_ID("load"));
+        cycles += ESP.getCycleCount() - start;
+        if (ok) {
+            sent++;
+        } else {
+            taskYIELD(); // Pool or queue full - give the dispatcher a moment
+        }
+    }
+
+    xSemaphoreTake(statsMutex, portMAX_DELAY);
+    sendCycles = sendCycles + cycles;
+    producersDone = producersDone + 1;
+    xSemaphoreGive(statsMutex);
+    vTaskDelete(nullptr);
+}
+
+void runSweep(ESPLooper::EventTransport transport, const char* label) {
+    while (ESP_LOOPER.events().getQueuedEvents() > 0) {
+        vTaskDelay(1);
+    }
+    ESP_LOOPER.events().setTransport(transport);
+
+    for (int producers : PRODUCER_COUNTS) {
+        received = 0;
+        sendCycles = 0;
+        producersDone = 0;
+
+        uint32_t total = producers * EVENTS_PER_PRODUCER;
+        uint32_t start = micros();
+
+        for (int i = 0; i < producers; i++) {
+            xTaskCreatePinnedToCore(producer, "producer", 2048, nullptr, 2,
+                                    nullptr, i % 2);
+        }
+        while (producersDone < producers || received < total) {
+            vTaskDelay(1);
+        }
+
+        uint32_t elapsed = micros() - start;
+        Serial.printf("%-5s producers %d: %7u events/s, %5u cycles/send\n",
+                      label, producers,
+                      (uint32_t)((uint64_t)total * 1000000 / elapsed),
+                      sendCycles / total);
+    }
+    Serial.println();
+}
+
+void setup() {
+    Serial.begin(115200);
+    delay(1000);
+
+    Serial.println("=== ESP-Looper Transport Contention Benchmark ===\n");
+
+    statsMutex = xSemaphoreCreateMutex();
+
+    ESPLooper::LooperConfig config;
+    config.eventPoolSize = 64;
+    ESP_LOOPER.begin(config);
+
+    ESP_LOOPER.events().on(EVENT_ID("load"), [](const ESPLooper::Event&) {
+        received = received + 1;
+    });
+
+    runSweep(ESPLooper::EventTransport::Queue, "Queue");
+    runSweep(ESPLooper::EventTransport::Ring, "Ring");
+
+    Serial.println("Done.");
+}
+
+void loop() {
+    vTaskDelay(portMAX_DELAY);
+}
@@ -0,0 +1,89 @@
+#include <ESPLooper.h>
+
+// Zero-copy sample frames between cores
+//
+// The producer loans a frame from the bus, fills it in place and publishes
+// it. Every listener sees the same memory; the analyzer keeps the frame past
+// its callback and hands it to a worker task without copying a byte.
+
+static constexpr size_t FRAME_SAMPLES = 1024;
+
+struct Frame {
+    uint32_t sequence;
+    int16_t samples[FRAME_SAMPLES];
+};
+
+static QueueHandle_t analysisQueue;
+
+void analysisWorker(void*) {
+    ESPLooper::BufferRef* held;
+    while (true) {
+        if (xQueueReceive(analysisQueue, &held, portMAX_DELAY) == pdTRUE) {
+            const Frame* frame = held->as<Frame>();
+            int32_t peak = 0;
+            for (size_t i = 0; i < FRAME_SAMPLES; i++) {
+                peak = max(peak, (int32_t)abs(frame->samples[i]));
+            }
+            Serial.printf("[Core %d] Frame %u peak %d (refs %u)\n",
+                          xPortGetCoreID(), frame->sequence, peak, held->useCount());
+            delete held; // Drops the last reference - frame returns to the pool
+        }
+    }
+}
+
+void setup() {
+    Serial.begin(115200);
+    delay(1000);
+
+    Serial.println("=== ESP-Looper Zero-Copy Example ===\n");
+
+    ESPLooper::LooperConfig config;
+    config.bufferPoolSize = 4;
+    config.bufferSize = sizeof(Frame);
+    ESP_LOOPER.begin(config);
+
+    analysisQueue = xQueueCreate(4, sizeof(ESPLooper::BufferRef*));
+    xTaskCreatePinnedToCore(analysisWorker, "analysis", 4096, nullptr, 1, nullptr, 1);
+
+    // Producer on core 0
+    ESP_TIMER("sampler", 250, []() {
+        static uint32_t sequence = 0;
+
+        ESPLooper::BufferRef buffer = ESP_LOOPER.events().loan(sizeof(Frame));
+        if (!buffer) {
+            Serial.println("[Sampler] No free frame - consumers are behind");
+            return;
+        }
+
+        Frame* frame = buffer.as<Frame>();
+        frame->sequence = sequence++;
+        for (size_t i = 0; i < FRAME_SAMPLES; i++) {
+            frame->samples[i] = random(-2048, 2048);
+        }
+
+        ESP_LOOPER.events().publish(EVENT_ID("frame"), buffer, sizeof(Frame));
+    }, true, 0);
+
+    // Quick look inside the callback
+    ESP_LISTENER("monitor", EVENT_ID("frame"), [](const ESPLooper::Event& evt) {
+        const Frame* frame = (const Frame*)evt.data;
+        Serial.printf("[Monitor] Frame %u, first sample %d\n",
+                      frame->sequence, frame->samples[0]);
+    });
+
+    // Keep the frame beyond the callback - no copy
+    ESP_LISTENER("analyzer", EVENT_ID("frame"), [](const ESPLooper::Event& evt) {
+        auto* held = new ESPLooper::BufferRef(evt.share());
+        if (xQueueSend(analysisQueue, &held, 0) != pdTRUE) {
+            delete held;
+        }
+    });
+
+    ESP_TIMER("stats", 5000, []() {
+        ESP_LOOPER.printStats();
+    });
+}
+
+void loop() {
+    vTaskDelay(portMAX_DELAY);
+}
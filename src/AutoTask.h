@@ -1,82 +1,185 @@
 #pragma once
 #include "Looper.h"
-#include <vector>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
 
 namespace ESPLooper {
 
-// Base class for automatically registered tasks
+// Base class for automatically registered tasks.
+// Every LP_* macro defines one static instance. Its constructor only links
+// it into an intrusive list (head/tail are constant-initialized, so this
+// works whatever order static constructors run in) - registration
+// allocates nothing, and the list costs one pointer per task.
 class AutoTask {
 public:
-    AutoTask() {
-        getRegistry().push_back(this);
+    AutoTask() : next(nullptr) {
+        *tail = this;
+        tail = &next;
     }
-    
+
     virtual ~AutoTask() = default;
-    
+
     // Initialize this task (called automatically by Looper::begin())
     virtual void init() = 0;
-    
-    // Static registry of all automatic tasks
-    static std::vector<AutoTask*>& getRegistry() {
-        static std::vector<AutoTask*> registry;
-        return registry;
+
+    // Registered tasks, in registration order
+    static AutoTask* first() { return head; }
+    AutoTask* getNext() const { return next; }
+
+    static size_t count() {
+        size_t n = 0;
+        for (AutoTask* task = head; task; task = task->next) {
+            n++;
+        }
+        return n;
     }
-    
+
     // Initialize all registered tasks
     static void initAll() {
-        for (auto* task : getRegistry()) {
+        for (AutoTask* task = head; task; task = task->next) {
             task->init();
         }
     }
+
+    AutoTask(const AutoTask&) = delete;
+    AutoTask& operator=(const AutoTask&) = delete;
+
+private:
+    AutoTask* next;
+
+    static inline AutoTask* head = nullptr;
+    static inline AutoTask** tail = &head;
+};
+
+// Static storage for the task an AutoTask creates. allocate_shared() puts
+// the task and its shared_ptr control block here instead of on the heap,
+// so the RAM of macro-registered tasks is fixed at link time. A control
+// block that doesn't fit fails to compile; only a slot that still holds a
+// task from an earlier begin() falls back to the heap.
+template <typename T>
+class TaskSlot {
+public:
+    template <typename U>
+    class Allocator {
+    public:
+        using value_type = U;
+        template <typename V>
+        struct rebind {
+            using other = Allocator<V>;
+        };
+
+        explicit Allocator(TaskSlot* slot) : slot(slot) {}
+        template <typename V>
+        Allocator(const Allocator<V>& other) : slot(other.slot) {}
+
+        // U is the control block type allocate_shared() rebinds to
+        U* allocate(size_t n) {
+            static_assert(sizeof(U) <= SIZE,
+                          "TaskSlot is too small for this shared_ptr control block");
+            static_assert(alignof(U) <= alignof(std::max_align_t),
+                          "TaskSlot storage is under-aligned for this control block");
+            return static_cast<U*>(slot->take(n * sizeof(U)));
+        }
+        void deallocate(U* p, size_t) { slot->give(p); }
+
+        template <typename V>
+        bool operator==(const Allocator<V>& other) const { return slot == other.slot; }
+        template <typename V>
+        bool operator!=(const Allocator<V>& other) const { return slot != other.slot; }
+
+    private:
+        TaskSlot* slot;
+        template <typename V> friend class Allocator;
+    };
+
+    constexpr TaskSlot() : storage{}, used(false) {}
+
+    template <typename... Args>
+    std::shared_ptr<T> make(Args&&... args) {
+        return std::allocate_shared<T>(Allocator<T>(this), std::forward<Args>(args)...);
+    }
+
+private:
+    // Control block: vtable, two counts and the allocator; allocate() checks
+    // it against the real type
+    static constexpr size_t SIZE = sizeof(T) + 4 * sizeof(void*);
+
+    alignas(std::max_align_t) unsigned char storage[SIZE];
+    bool used;
+
+    void* take(size_t bytes) {
+        if (bytes <= SIZE && !used) {
+            used = true;
+            return storage;
+        }
+        return ::operator new(bytes);
+    }
+
+    void give(void* block) {
+        if (block == storage) {
+            used = false;
+        } else {
+            ::operator delete(block);
+        }
+    }
 };
 
 // Auto-registered timer task
 class AutoTimer : public AutoTask {
 public:
-    AutoTimer(const char* name, uint32_t period, Task::TaskCallback callback, 
+    AutoTimer(const char* name, uint32_t period, Task::TaskCallback callback,
               bool autoStart = true, BaseType_t coreId = tskNO_AFFINITY,
               uint32_t stackSize = 4096, UBaseType_t priority = 1)
-        : name(name), period(period), callback(callback), 
-          autoStart(autoStart), coreId(coreId), 
+        : name(name), period(period), callback(callback),
+          autoStart(autoStart), coreId(coreId),
           stackSize(stackSize), priority(priority) {}
-    
+
     void init() override {
-        ESPLooper::Looper::getInstance().addTimer(name, callback, period, 
-                                      autoStart, coreId, stackSize, priority);
+        ESPLooper::Looper::getInstance().addTimer(
+            name, slot.make(name, callback, period, autoStart, stackSize,
+                            priority, coreId));
     }
-    
+
 private:
-    const char* name;
-    uint32_t period;
-    Task::TaskCallback callback;
-    bool autoStart;
-    BaseType_t coreId;
-    uint32_t stackSize;
-    UBaseType_t priority;
+    const char* const name;
+    const uint32_t period;
+    const Task::TaskCallback callback;
+    const bool autoStart;
+    const BaseType_t coreId;
+    const uint32_t stackSize;
+    const UBaseType_t priority;
+    TaskSlot<TimerTask> slot;
 };
 
 // Auto-registered listener task
 class AutoListener : public AutoTask {
 public:
-    AutoListener(const char* name, uint32_t eventId, 
+    AutoListener(const char* name, uint32_t eventId,
                 ListenerTask::EventCallback callback,
                 BaseType_t coreId = tskNO_AFFINITY,
-                uint32_t stackSize = 4096, UBaseType_t priority = 1)
+                uint32_t stackSize = 4096, UBaseType_t priority = 1,
+                size_t mailboxDepth = 0)
         : name(name), eventId(eventId), callback(callback),
-          coreId(coreId), stackSize(stackSize), priority(priority) {}
-    
+          coreId(coreId), stackSize(stackSize), priority(priority),
+          mailboxDepth(mailboxDepth) {}
+
     void init() override {
-        ESPLooper::Looper::getInstance().addListener(name, eventId, callback, 
-                                         coreId, stackSize, priority);
+        ESPLooper::Looper::getInstance().addListener(
+            name, slot.make(name, eventId, callback, stackSize, priority,
+                            coreId, mailboxDepth));
     }
-    
+
 private:
-    const char* name;
-    uint32_t eventId;
-    ListenerTask::EventCallback callback;
-    BaseType_t coreId;
-    uint32_t stackSize;
-    UBaseType_t priority;
+    const char* const name;
+    const uint32_t eventId;
+    const ListenerTask::EventCallback callback;
+    const BaseType_t coreId;
+    const uint32_t stackSize;
+    const UBaseType_t priority;
+    const size_t mailboxDepth;
+    TaskSlot<ListenerTask> slot;
 };
 
 } // namespace ESPLooper
@@ -0,0 +1,308 @@
+#pragma once
+#include "RingBuffer.h"
+#include <freertos/FreeRTOS.h>
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <type_traits>
+
+// Threads that can be parked on one side of a channel at once; beyond that
+// LP_CHANNEL_SEND/RECV fall back to re-trying every tick
+#ifndef LP_CHANNEL_WAITERS
+#define LP_CHANNEL_WAITERS 4
+#endif
+
+namespace ESPLooper {
+
+// Outcome of a send/recv that may park the caller
+enum class ChannelStatus : uint8_t {
+    Done,    // Element sent/received
+    Waiting, // Registered: wake() is called when it may succeed
+    Busy     // Waiter table full: retry later without being woken
+};
+
+// How a channel wakes a parked caller
+struct ChannelWaiter {
+    void (*wake)(void* ctx);
+    void* ctx;
+};
+
+// Parked callers of one side of a channel. Wakes are one-shot: a woken
+// caller re-registers if its retry fails again.
+class ChannelWaitList {
+public:
+    ChannelWaitList() : lock(portMUX_INITIALIZER_UNLOCKED), count(0) {}
+
+    bool add(const ChannelWaiter& waiter) {
+        bool added = false;
+        portENTER_CRITICAL(&lock);
+        size_t n = count.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < n; i++) {
+            if (slots[i].ctx == waiter.ctx) {
+                added = true;
+                break;
+            }
+        }
+        if (!added && n < LP_CHANNEL_WAITERS) {
+            slots[n] = waiter;
+            count.store(n + 1, std::memory_order_relaxed);
+            added = true;
+        }
+        portEXIT_CRITICAL(&lock);
+
+        // Pairs with the fence in wakeAll(): either our retry sees the
+        // other side's update or it sees us registered
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        return added;
+    }
+
+    void remove(void* ctx) {
+        if (count.load(std::memory_order_relaxed) == 0) {
+            return;
+        }
+        portENTER_CRITICAL(&lock);
+        size_t n = count.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < n; i++) {
+            if (slots[i].ctx == ctx) {
+                slots[i] = slots[n - 1];
+                count.store(n - 1, std::memory_order_relaxed);
+                break;
+            }
+        }
+        portEXIT_CRITICAL(&lock);
+    }
+
+    void wakeAll() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (count.load(std::memory_order_relaxed) == 0) {
+            return;
+        }
+
+        // Wake outside the lock - waking may notify a task
+        ChannelWaiter woken[LP_CHANNEL_WAITERS];
+        portENTER_CRITICAL(&lock);
+        size_t n = count.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < n; i++) {
+            woken[i] = slots[i];
+        }
+        count.store(0, std::memory_order_relaxed);
+        portEXIT_CRITICAL(&lock);
+
+        for (size_t i = 0; i < n; i++) {
+            woken[i].wake(woken[i].ctx);
+        }
+    }
+
+private:
+    portMUX_TYPE lock;
+    std::atomic<size_t> count;
+    ChannelWaiter slots[LP_CHANNEL_WAITERS];
+};
+
+// Untyped part of every channel: lets a parked thread deregister itself
+class ChannelBase {
+public:
+    // Drop `ctx` from both wait lists (e.g. its thread is being destroyed)
+    void cancel(void* ctx) {
+        senders.remove(ctx);
+        receivers.remove(ctx);
+    }
+
+protected:
+    ChannelWaitList senders;
+    ChannelWaitList receivers;
+};
+
+#if defined(__cpp_impl_coroutine)
+// co_await awaiters, defined in Coroutine.h
+template <typename Ch, typename T> class CoSend;
+template <typename Ch, typename T> class CoRecv;
+#endif
+
+// Shared blocking layer over a ring with trySend()/tryRecv()
+template <typename Derived, typename T>
+class ChannelOps : public ChannelBase {
+public:
+    // Send, or register `waiter` to be woken when there may be space
+    ChannelStatus send(const T& value, const ChannelWaiter& waiter) {
+        return park(senders, waiter, [&] { return self().trySend(value); });
+    }
+
+    // Receive into `value`, or register `waiter` to be woken when there may
+    // be data
+    ChannelStatus recv(T& value, const ChannelWaiter& waiter) {
+        return park(receivers, waiter, [&] { return self().tryRecv(value); });
+    }
+
+#if defined(__cpp_impl_coroutine)
+    // From a CoTask: co_await ch.send(value) / T value = co_await ch.recv()
+    CoSend<Derived, T> send(const T& value) { return CoSend<Derived, T>(self(), value); }
+    CoRecv<Derived, T> recv() { return CoRecv<Derived, T>(self()); }
+#endif
+
+private:
+    Derived& self() { return static_cast<Derived&>(*this); }
+
+    template <typename Attempt>
+    ChannelStatus park(ChannelWaitList& list, const ChannelWaiter& waiter,
+                       Attempt attempt) {
+        if (attempt()) {
+            list.remove(waiter.ctx);
+            return ChannelStatus::Done;
+        }
+        if (!list.add(waiter)) {
+            return ChannelStatus::Busy;
+        }
+        // The other side may have moved before we registered
+        if (attempt()) {
+            list.remove(waiter.ctx);
+            return ChannelStatus::Done;
+        }
+        return ChannelStatus::Waiting;
+    }
+};
+
+// Bounded multi-producer multi-consumer channel of N elements, stored in the
+// object itself (no heap). Each element is copied in once and out once.
+// Per-cell sequence numbers (Vyukov) let senders and receivers on either
+// core claim cells with one CAS each. trySend()/tryRecv() never block and
+// are safe from any task; LP_CHANNEL_SEND/RECV park an LP_THREAD instead.
+template <typename T, size_t N>
+class Channel : public ChannelOps<Channel<T, N>, T> {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "Channel elements must be trivially copyable");
+    static_assert(N >= 2 && (N & (N - 1)) == 0,
+                  "Channel capacity must be a power of two");
+
+public:
+    Channel() : tail(0), head(0) {
+        for (size_t i = 0; i < N; i++) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool trySend(const T& value) {
+        uint32_t pos = tail.load(std::memory_order_relaxed);
+        Cell* cell;
+
+        while (true) {
+            cell = &cells[pos & (N - 1)];
+            uint32_t seq = cell->sequence.load(std::memory_order_acquire);
+            int32_t diff = (int32_t)(seq - pos);
+
+            if (diff == 0) {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false; // Full
+            } else {
+                pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->value = value;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        this->receivers.wakeAll();
+        return true;
+    }
+
+    bool tryRecv(T& value) {
+        uint32_t pos = head.load(std::memory_order_relaxed);
+        Cell* cell;
+
+        while (true) {
+            cell = &cells[pos & (N - 1)];
+            uint32_t seq = cell->sequence.load(std::memory_order_acquire);
+            int32_t diff = (int32_t)(seq - (pos + 1));
+
+            if (diff == 0) {
+                if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false; // Empty
+            } else {
+                pos = head.load(std::memory_order_relaxed);
+            }
+        }
+
+        value = cell->value;
+        cell->sequence.store(pos + N, std::memory_order_release);
+        this->senders.wakeAll();
+        return true;
+    }
+
+    size_t size() const {
+        return tail.load(std::memory_order_relaxed) - head.load(std::memory_order_relaxed);
+    }
+
+    static constexpr size_t capacity() { return N; }
+
+    Channel(const Channel&) = delete;
+    Channel& operator=(const Channel&) = delete;
+
+private:
+    struct Cell {
+        std::atomic<uint32_t> sequence;
+        T value;
+    };
+
+    Cell cells[N];
+
+    alignas(LP_CACHE_LINE_SIZE) std::atomic<uint32_t> tail; // Senders
+    alignas(LP_CACHE_LINE_SIZE) std::atomic<uint32_t> head; // Receivers
+};
+
+// Bounded single-producer single-consumer channel: one sender task and one
+// receiver task at a time. No CAS and no per-cell sequence, so each
+// operation is a load, a copy and a release store.
+template <typename T, size_t N>
+class SpscChannel : public ChannelOps<SpscChannel<T, N>, T> {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "Channel elements must be trivially copyable");
+    static_assert(N >= 2 && (N & (N - 1)) == 0,
+                  "Channel capacity must be a power of two");
+
+public:
+    SpscChannel() : tail(0), head(0) {}
+
+    bool trySend(const T& value) {
+        uint32_t pos = tail.load(std::memory_order_relaxed);
+        if (pos - head.load(std::memory_order_acquire) == N) {
+            return false; // Full
+        }
+        cells[pos & (N - 1)] = value;
+        tail.store(pos + 1, std::memory_order_release);
+        this->receivers.wakeAll();
+        return true;
+    }
+
+    bool tryRecv(T& value) {
+        uint32_t pos = head.load(std::memory_order_relaxed);
+        if (tail.load(std::memory_order_acquire) == pos) {
+            return false; // Empty
+        }
+        value = cells[pos & (N - 1)];
+        head.store(pos + 1, std::memory_order_release);
+        this->senders.wakeAll();
+        return true;
+    }
+
+    size_t size() const {
+        return tail.load(std::memory_order_relaxed) - head.load(std::memory_order_relaxed);
+    }
+
+    static constexpr size_t capacity() { return N; }
+
+    SpscChannel(const SpscChannel&) = delete;
+    SpscChannel& operator=(const SpscChannel&) = delete;
+
+private:
+    T cells[N];
+
+    alignas(LP_CACHE_LINE_SIZE) std::atomic<uint32_t> tail; // Sender
+    alignas(LP_CACHE_LINE_SIZE) std::atomic<uint32_t> head; // Receiver
+};
+
+} // namespace ESPLooper
@@ -0,0 +1,70 @@
+#pragma once
+#include <atomic>
+#include <stddef.h>
+
+namespace ESPLooper {
+
+// Latest undelivered value of a conflated event ID, one per dispatcher.
+//
+// The sender that fills an empty slot owes the dispatcher one ticket (a
+// queue entry pointing at the slot); senders that find a value already
+// there just replace it and release the old one, relying on that ticket.
+// When the dispatcher pops the ticket it take()s whatever value is latest.
+template <typename T, size_t Cores>
+class LastValueSlot {
+public:
+    LastValueSlot() {
+        for (auto& value : values) {
+            value.store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    // Store `value` for `core`. Returns the value it replaced, which the
+    // caller releases, or nullptr when the slot was empty and the caller
+    // must queue a ticket.
+    T* offer(size_t core, T* value) {
+        return values[core].exchange(value, std::memory_order_acq_rel);
+    }
+
+    // The ticket for `core` was dispatched: take the latest value
+    T* take(size_t core) {
+        return values[core].exchange(nullptr, std::memory_order_acq_rel);
+    }
+
+    // The ticket owed for `value` could not be queued. Withdraws `value`,
+    // unless a newer value has replaced it meanwhile: its sender already
+    // released ours and counts on the ticket, so `queueTicket()` is tried
+    // again and, only if that fails too, the newest value is withdrawn.
+    // Returns the withdrawn value for the caller to release, or nullptr
+    // when a ticket now covers the slot.
+    template <typename QueueTicket>
+    T* withdraw(size_t core, T* value, QueueTicket&& queueTicket) {
+        T* current = value;
+        while (!values[core].compare_exchange_strong(current, nullptr,
+                                                     std::memory_order_acq_rel,
+                                                     std::memory_order_acquire)) {
+            if (!current || queueTicket()) {
+                return nullptr;
+            }
+        }
+        return current;
+    }
+
+    // No value waits for any dispatcher
+    bool drained() const {
+        for (const auto& value : values) {
+            if (value.load(std::memory_order_acquire)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    LastValueSlot(const LastValueSlot&) = delete;
+    LastValueSlot& operator=(const LastValueSlot&) = delete;
+
+private:
+    std::atomic<T*> values[Cores];
+};
+
+} // namespace ESPLooper
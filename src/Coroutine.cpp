@@ -0,0 +1,412 @@
+#include "Coroutine.h"
+
+#if defined(__cpp_impl_coroutine)
+
+#include "Pool.h"
+#include <algorithm>
+#include <new>
+
+namespace ESPLooper {
+
+// ===== CoFrameArena =====
+
+static BlockPool framePool;
+static std::atomic<size_t> largestFrame{0};
+static std::atomic<uint32_t> failedFrames{0};
+
+bool CoFrameArena::configure(size_t frameSize, size_t count) {
+  if (framePool.isEnabled() || count == 0) {
+    return false;
+  }
+  return framePool.begin(frameSize, count);
+}
+
+void *CoFrameArena::allocate(size_t size) {
+  size_t largest = largestFrame.load(std::memory_order_relaxed);
+  while (size > largest &&
+         !largestFrame.compare_exchange_weak(largest, size,
+                                             std::memory_order_relaxed)) {
+  }
+
+  if (!framePool.isEnabled()) {
+    return ::operator new(size, std::nothrow);
+  }
+
+  void *frame = size <= framePool.getBlockSize() ? framePool.acquire() : nullptr;
+  if (!frame) {
+    failedFrames.fetch_add(1, std::memory_order_relaxed);
+  }
+  return frame;
+}
+
+void CoFrameArena::release(void *frame, size_t) {
+  if (framePool.owns(frame)) {
+    framePool.release(frame);
+  } else {
+    ::operator delete(frame);
+  }
+}
+
+CoFrameArena::Stats CoFrameArena::getStats() {
+  Stats stats;
+  stats.frameSize = framePool.isEnabled() ? framePool.getBlockSize() : 0;
+  stats.capacity = framePool.getCapacity();
+  stats.inUse = framePool.getInUse();
+  stats.largestFrame = largestFrame.load(std::memory_order_relaxed);
+  stats.failed = failedFrames.load(std::memory_order_relaxed);
+  return stats;
+}
+
+// ===== CoTask =====
+
+CoTask &CoTask::operator=(CoTask &&other) noexcept {
+  if (this != &other) {
+    if (handle) {
+      handle.destroy();
+    }
+    handle = other.handle;
+    other.handle = nullptr;
+  }
+  return *this;
+}
+
+CoTask::~CoTask() {
+  // Never spawned: the frame is still ours
+  if (handle) {
+    handle.destroy();
+  }
+}
+
+// ===== CoScheduler =====
+
+static CoScheduler *schedulers[portNUM_PROCESSORS] = {};
+
+CoScheduler::CoScheduler()
+    : readyHead(nullptr), readyTail(nullptr), sleeping(nullptr),
+      lock(portMUX_INITIALIZER_UNLOCKED), handle(nullptr), coroutineCount(0),
+      resumes(0), wakeups(0) {}
+
+bool CoScheduler::createSchedulers(UBaseType_t priority, uint32_t stackSize) {
+  for (size_t i = 0; i < portNUM_PROCESSORS; i++) {
+    if (schedulers[i]) {
+      continue;
+    }
+
+    CoScheduler *scheduler = new CoScheduler();
+    if (xTaskCreatePinnedToCore(schedulerTask, "CoScheduler", stackSize,
+                                scheduler, priority, &scheduler->handle,
+                                i) != pdPASS) {
+      delete scheduler;
+      return false;
+    }
+    schedulers[i] = scheduler;
+  }
+  return true;
+}
+
+CoScheduler *CoScheduler::forCore(BaseType_t coreId) {
+  if (coreId >= 0 && coreId < portNUM_PROCESSORS) {
+    return schedulers[coreId];
+  }
+
+  CoScheduler *best = nullptr;
+  for (CoScheduler *scheduler : schedulers) {
+    if (scheduler &&
+        (!best || scheduler->coroutineCount < best->coroutineCount)) {
+      best = scheduler;
+    }
+  }
+  return best;
+}
+
+bool CoScheduler::spawn(CoTask &&task) {
+  if (!task) {
+    return false;
+  }
+
+  CoTask::Handle frame = task.release();
+  CoNode *node = &frame.promise().node;
+  node->handle = frame;
+  node->scheduler = this;
+
+  portENTER_CRITICAL(&lock);
+  coroutineCount++;
+  pushReady(node);
+  portEXIT_CRITICAL(&lock);
+
+  xTaskNotifyGive(handle);
+  return true;
+}
+
+void CoScheduler::wake(CoNode *node) {
+  bool notify = false;
+
+  portENTER_CRITICAL(&lock);
+  if (node->state == CoNode::State::Parked) {
+    pushReady(node);
+    notify = true;
+  } else if (node->state == CoNode::State::Running) {
+    // Parking right now - commit() sees the flag
+    node->woken = true;
+  }
+  portEXIT_CRITICAL(&lock);
+
+  if (notify) {
+    xTaskNotifyGive(handle);
+  }
+}
+
+void CoScheduler::wakeNode(void *ctx) {
+  CoNode *node = static_cast<CoNode *>(ctx);
+  node->scheduler->wake(node);
+}
+
+void CoScheduler::pushReady(CoNode *node) {
+  node->state = CoNode::State::Ready;
+  node->next = nullptr;
+  if (readyTail) {
+    readyTail->next = node;
+  } else {
+    readyHead = node;
+  }
+  readyTail = node;
+}
+
+void CoScheduler::commit(CoNode *node) {
+  // Called with the lock held, after the frame suspended again
+  if (node->request == CoNode::State::Sleeping) {
+    node->state = CoNode::State::Sleeping;
+    node->next = sleeping;
+    sleeping = node;
+  } else if (node->woken) {
+    // Woken between registering and suspending
+    pushReady(node);
+  } else {
+    node->state = CoNode::State::Parked;
+  }
+}
+
+void CoScheduler::schedulerLoop() {
+  while (true) {
+    TickType_t sleep = portMAX_DELAY;
+
+    portENTER_CRITICAL(&lock);
+    TickType_t now = xTaskGetTickCount();
+    for (CoNode **link = &sleeping; *link;) {
+      CoNode *node = *link;
+      int32_t remaining = static_cast<int32_t>(node->wakeAt - now);
+      if (remaining <= 0) {
+        *link = node->next;
+        pushReady(node);
+      } else {
+        link = &node->next;
+      }
+    }
+
+    // Run what is ready now; anything readied meanwhile waits for the
+    // next pass
+    CoNode *batch = readyHead;
+    readyHead = readyTail = nullptr;
+
+    while (CoNode *node = batch) {
+      batch = node->next;
+      node->state = CoNode::State::Running;
+      node->request = CoNode::State::Parked;
+      node->woken = false;
+      portEXIT_CRITICAL(&lock);
+
+      bool resume = !node->retry || node->retry(node->awaiter, node);
+      bool done = false;
+      if (resume) {
+        node->retry = nullptr;
+        node->handle.resume();
+        resumes++;
+        done = node->handle.done();
+      }
+
+      if (done) {
+        node->handle.destroy();
+        portENTER_CRITICAL(&lock);
+        coroutineCount--;
+      } else {
+        portENTER_CRITICAL(&lock);
+        commit(node);
+      }
+    }
+
+    now = xTaskGetTickCount();
+    for (CoNode *node = sleeping; node; node = node->next) {
+      int32_t remaining = static_cast<int32_t>(node->wakeAt - now);
+      sleep = std::min<TickType_t>(sleep, remaining > 0 ? remaining : 0);
+    }
+    if (readyHead) {
+      sleep = 0;
+    }
+    portEXIT_CRITICAL(&lock);
+
+    if (sleep > 0) {
+      ulTaskNotifyTake(pdTRUE, sleep);
+      wakeups++;
+    } else {
+      taskYIELD();
+    }
+  }
+}
+
+void CoScheduler::schedulerTask(void *parameter) {
+  static_cast<CoScheduler *>(parameter)->schedulerLoop();
+}
+
+CoScheduler::Stats CoScheduler::getStats() const {
+  Stats stats;
+  stats.coroutines = coroutineCount;
+  stats.resumes = resumes;
+  stats.wakeups = wakeups;
+  return stats;
+}
+
+bool spawn(CoTask task, BaseType_t coreId) {
+  CoScheduler *scheduler = CoScheduler::forCore(coreId);
+  return scheduler && scheduler->spawn(std::move(task));
+}
+
+// ===== co_await event(id) =====
+
+// Coroutines waiting in co_await event(). One onAny() subscription, made on
+// first use, hands matching events over; it returns at once while the
+// table is empty.
+class CoEventWaiters {
+public:
+  static bool add(CoEvent *waiter) {
+    subscribe();
+
+    bool added = false;
+    portENTER_CRITICAL(&lock);
+    size_t n = count.load(std::memory_order_relaxed);
+    if (n < LP_CO_EVENT_WAITERS) {
+      slots[n] = waiter;
+      count.store(n + 1, std::memory_order_relaxed);
+      added = true;
+    }
+    portEXIT_CRITICAL(&lock);
+    return added;
+  }
+
+  // The awaiter is going away: it must not be handed an event or woken
+  // after this returns
+  static void remove(CoEvent *waiter) {
+    bool found = false;
+    portENTER_CRITICAL(&lock);
+    size_t n = count.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < n; i++) {
+      if (slots[i] == waiter) {
+        slots[i] = slots[n - 1];
+        count.store(n - 1, std::memory_order_relaxed);
+        found = true;
+        break;
+      }
+    }
+    portEXIT_CRITICAL(&lock);
+
+    // Handed an event but not resumed: deliver() may still be about to
+    // wake its node
+    while (!found && waiter->received &&
+           waking.load(std::memory_order_acquire) != 0) {
+      vTaskDelay(1);
+    }
+  }
+
+  static void deliver(const Event &event) {
+    if (count.load(std::memory_order_relaxed) == 0) {
+      return;
+    }
+
+    EventBus &bus = EventBus::getInstance();
+    CoNode *woken[LP_CO_EVENT_WAITERS];
+    size_t wokenCount = 0;
+
+    portENTER_CRITICAL(&lock);
+    size_t n = count.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < n;) {
+      CoEvent *waiter = slots[i];
+      if (waiter->id != event.id) {
+        i++;
+        continue;
+      }
+      waiter->received = bus.retainEvent(event);
+      woken[wokenCount++] = waiter->node;
+      slots[i] = slots[--n];
+    }
+    count.store(n, std::memory_order_relaxed);
+    if (wokenCount > 0) {
+      waking.fetch_add(1, std::memory_order_relaxed);
+    }
+    portEXIT_CRITICAL(&lock);
+
+    if (wokenCount > 0) {
+      for (size_t i = 0; i < wokenCount; i++) {
+        woken[i]->scheduler->wake(woken[i]);
+      }
+      waking.fetch_sub(1, std::memory_order_release);
+    }
+  }
+
+private:
+  static void subscribe() {
+    if (subscribed.exchange(true)) {
+      return;
+    }
+    EventBus::getInstance().onAny(deliver);
+  }
+
+  static portMUX_TYPE lock;
+  static CoEvent *slots[LP_CO_EVENT_WAITERS];
+  static std::atomic<size_t> count;
+  static std::atomic<bool> subscribed;
+  static std::atomic<uint32_t> waking; // deliver() calls still waking nodes
+};
+
+portMUX_TYPE CoEventWaiters::lock = portMUX_INITIALIZER_UNLOCKED;
+CoEvent *CoEventWaiters::slots[LP_CO_EVENT_WAITERS] = {};
+std::atomic<size_t> CoEventWaiters::count{0};
+std::atomic<bool> CoEventWaiters::subscribed{false};
+std::atomic<uint32_t> CoEventWaiters::waking{0};
+
+CoEvent::~CoEvent() {
+  // Destroyed while parked, e.g. with its frame
+  if (node) {
+    CoEventWaiters::remove(this);
+  }
+  // Delivered but never resumed
+  if (received) {
+    EventBus::getInstance().releaseEvent(received);
+  }
+}
+
+bool CoEvent::await_suspend(CoTask::Handle h) {
+  node = &h.promise().node;
+  if (!attempt(this, node)) {
+    node->retry = &attempt;
+    node->awaiter = this;
+  }
+  return true;
+}
+
+bool CoEvent::attempt(void *self, CoNode *node) {
+  CoEvent *waiter = static_cast<CoEvent *>(self);
+  if (waiter->received) {
+    return true;
+  }
+  if (!CoEventWaiters::add(waiter)) {
+    // Table full: try again next tick
+    node->request = CoNode::State::Sleeping;
+    node->wakeAt = xTaskGetTickCount() + 1;
+    return false;
+  }
+  node->request = CoNode::State::Parked;
+  return false;
+}
+
+} // namespace ESPLooper
+
+#endif // __cpp_impl_coroutine
@@ -0,0 +1,321 @@
+#pragma once
+
+// Stackless coroutine tasks (C++20). Needs a toolchain with coroutine
+// support - arduino-esp32 3.x (GCC 12+, -std=gnu++2b); with older cores
+// this header is empty.
+#if defined(__cpp_impl_coroutine)
+
+#include "Channel.h"
+#include "Event.h"
+#include <coroutine>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <stdlib.h>
+
+// Coroutines that can wait in co_await event(id) at once; beyond that they
+// re-try registering every tick
+#ifndef LP_CO_EVENT_WAITERS
+#define LP_CO_EVENT_WAITERS 16
+#endif
+
+namespace ESPLooper {
+
+class CoScheduler;
+
+// Scheduling state of one coroutine, kept in its promise
+struct CoNode {
+    enum class State : uint8_t {
+        Ready,    // On the run queue
+        Running,  // Being resumed by its scheduler
+        Sleeping, // Until wakeAt
+        Parked    // Until wake()
+    };
+
+    CoNode* next = nullptr;
+    std::coroutine_handle<> handle;
+    CoScheduler* scheduler = nullptr;
+    TickType_t wakeAt = 0;
+    State state = State::Ready;
+    State request = State::Ready; // How an awaiter asked to be suspended
+    bool woken = false;           // wake() arrived while Running
+
+    // Set by awaiters that must re-try before the coroutine may continue
+    // (channel ops). Runs on the scheduler instead of resuming the frame;
+    // false = suspend again as `request` says.
+    bool (*retry)(void* awaiter, CoNode* node) = nullptr;
+    void* awaiter = nullptr;
+};
+
+// Frames come from a fixed pool of equally sized blocks when
+// LooperConfig::coroutineFrames > 0 (never the heap then - a frame that
+// doesn't fit or an empty pool makes the coroutine call return an empty
+// CoTask), otherwise from the heap.
+class CoFrameArena {
+public:
+    static bool configure(size_t frameSize, size_t count);
+
+    static void* allocate(size_t size);
+    static void release(void* frame, size_t size);
+
+    struct Stats {
+        size_t frameSize;     // Block size (0 = heap frames)
+        size_t capacity;
+        size_t inUse;
+        size_t largestFrame;  // Biggest frame requested so far
+        uint32_t failed;      // Requests the arena couldn't serve
+    };
+    static Stats getStats();
+};
+
+// Coroutine return type: `CoTask blink() { ...co_await delay(500); ... }`.
+// Calling the function only creates the frame; spawn() hands it to a
+// scheduler, which destroys it when the body returns.
+class CoTask {
+public:
+    struct promise_type {
+        CoNode node;
+
+        static void* operator new(size_t size) noexcept {
+            return CoFrameArena::allocate(size);
+        }
+        static void operator delete(void* frame, size_t size) noexcept {
+            CoFrameArena::release(frame, size);
+        }
+        static CoTask get_return_object_on_allocation_failure() { return CoTask(); }
+
+        CoTask get_return_object() {
+            return CoTask(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { abort(); }
+    };
+    using Handle = std::coroutine_handle<promise_type>;
+
+    CoTask() : handle(nullptr) {}
+    CoTask(CoTask&& other) noexcept : handle(other.handle) { other.handle = nullptr; }
+    CoTask& operator=(CoTask&& other) noexcept;
+    ~CoTask();
+
+    // False when the frame could not be allocated
+    explicit operator bool() const { return handle != nullptr; }
+
+    // Give up ownership (the scheduler takes it)
+    Handle release() {
+        Handle taken = handle;
+        handle = nullptr;
+        return taken;
+    }
+
+    CoTask(const CoTask&) = delete;
+    CoTask& operator=(const CoTask&) = delete;
+
+private:
+    explicit CoTask(Handle handle) : handle(handle) {}
+
+    Handle handle;
+};
+
+// Resumes coroutines on one task per core (LooperConfig::coroutines).
+// The run queue is FIFO; sleeping coroutines sit on a timer list and the
+// task sleeps until the earliest of them, parked ones cost nothing until
+// wake(). Like Executor entries, a coroutine must not block between
+// co_awaits.
+class CoScheduler {
+public:
+    // Schedulers are created by Looper::begin(), one pinned to each core
+    static bool createSchedulers(UBaseType_t priority, uint32_t stackSize);
+
+    // Scheduler for a core hint; unpinned picks the least loaded one
+    static CoScheduler* forCore(BaseType_t coreId);
+
+    // Take ownership of `task` and run it; false if it is empty
+    bool spawn(CoTask&& task);
+
+    // Make a Parked coroutine runnable (from any task, not ISRs)
+    void wake(CoNode* node);
+
+    // ChannelWaiter / waiter-table callback: ctx is a CoNode
+    static void wakeNode(void* ctx);
+
+    struct Stats {
+        size_t coroutines;  // Alive on this scheduler
+        uint32_t resumes;   // Frame resumptions (context switches)
+        uint32_t wakeups;   // Times the scheduler task woke up
+    };
+    Stats getStats() const;
+    TaskHandle_t getHandle() const { return handle; }
+
+private:
+    CoScheduler();
+
+    CoNode* readyHead;
+    CoNode* readyTail;
+    CoNode* sleeping;
+    portMUX_TYPE lock;
+    TaskHandle_t handle;
+    size_t coroutineCount;
+    uint32_t resumes;
+    uint32_t wakeups;
+
+    void pushReady(CoNode* node);
+    void commit(CoNode* node);
+    void schedulerLoop();
+
+    static void schedulerTask(void* parameter);
+};
+
+// Run `task` on the scheduler of `coreId` (any core by default)
+bool spawn(CoTask task, BaseType_t coreId = tskNO_AFFINITY);
+
+// An event kept alive for the coroutine that received it
+class HeldEvent {
+public:
+    explicit HeldEvent(Event* event) : event(event) {}
+    HeldEvent(HeldEvent&& other) noexcept : event(other.event) { other.event = nullptr; }
+    ~HeldEvent() {
+        if (event) {
+            EventBus::getInstance().releaseEvent(event);
+        }
+    }
+
+    const Event& operator*() const { return *event; }
+    const Event* operator->() const { return event; }
+    void* data() const { return event->data; }
+
+    HeldEvent(const HeldEvent&) = delete;
+    HeldEvent& operator=(const HeldEvent&) = delete;
+
+private:
+    Event* event;
+};
+
+// ===== Awaitables =====
+
+// co_await delay(ms): sleep on the scheduler's timer list (0 = yield)
+class CoDelay {
+public:
+    explicit CoDelay(TickType_t ticks) : ticks(ticks) {}
+
+    bool await_ready() const { return false; }
+    void await_suspend(CoTask::Handle h) {
+        CoNode& node = h.promise().node;
+        node.request = CoNode::State::Sleeping;
+        node.wakeAt = xTaskGetTickCount() + ticks;
+    }
+    void await_resume() const {}
+
+private:
+    TickType_t ticks;
+};
+
+inline CoDelay delay(uint32_t ms) { return CoDelay(pdMS_TO_TICKS(ms)); }
+
+// co_await event(id): park until an event with `id` is sent; resumes with
+// the event held until the HeldEvent goes away
+class CoEvent {
+public:
+    explicit CoEvent(uint32_t id) : id(id), node(nullptr), received(nullptr) {}
+    ~CoEvent();
+
+    bool await_ready() const { return false; }
+    bool await_suspend(CoTask::Handle h);
+    HeldEvent await_resume() {
+        Event* event = received;
+        received = nullptr;
+        return HeldEvent(event);
+    }
+
+    CoEvent(const CoEvent&) = delete;
+    CoEvent& operator=(const CoEvent&) = delete;
+
+private:
+    uint32_t id;
+    CoNode* node;
+    Event* volatile received;
+
+    static bool attempt(void* self, CoNode* node);
+    friend class CoEventWaiters;
+};
+
+inline CoEvent event(uint32_t id) { return CoEvent(id); }
+inline CoEvent event(const char* name) { return CoEvent(EVENT_ID(name)); }
+
+// Shared by CoSend/CoRecv: turn a channel result into a suspend request
+inline bool coChannelDone(ChannelStatus status, CoNode* node) {
+    switch (status) {
+    case ChannelStatus::Done:
+        return true;
+    case ChannelStatus::Waiting:
+        node->request = CoNode::State::Parked;
+        return false;
+    default:
+        // Too many waiters to be woken: try again next tick
+        node->request = CoNode::State::Sleeping;
+        node->wakeAt = xTaskGetTickCount() + 1;
+        return false;
+    }
+}
+
+// co_await ch.send(value)
+template <typename Ch, typename T>
+class CoSend {
+public:
+    CoSend(Ch& channel, const T& value) : channel(channel), value(value) {}
+
+    bool await_ready() { return channel.trySend(value); }
+    bool await_suspend(CoTask::Handle h) {
+        CoNode* node = &h.promise().node;
+        if (attempt(this, node)) {
+            return false;
+        }
+        node->retry = &attempt;
+        node->awaiter = this;
+        return true;
+    }
+    void await_resume() const {}
+
+private:
+    Ch& channel;
+    const T& value; // The co_await expression keeps it alive
+
+    static bool attempt(void* self, CoNode* node) {
+        CoSend* send = static_cast<CoSend*>(self);
+        return coChannelDone(
+            send->channel.send(send->value, {&CoScheduler::wakeNode, node}), node);
+    }
+};
+
+// T value = co_await ch.recv()
+template <typename Ch, typename T>
+class CoRecv {
+public:
+    explicit CoRecv(Ch& channel) : channel(channel), value() {}
+
+    bool await_ready() { return channel.tryRecv(value); }
+    bool await_suspend(CoTask::Handle h) {
+        CoNode* node = &h.promise().node;
+        if (attempt(this, node)) {
+            return false;
+        }
+        node->retry = &attempt;
+        node->awaiter = this;
+        return true;
+    }
+    T await_resume() const { return value; }
+
+private:
+    Ch& channel;
+    T value;
+
+    static bool attempt(void* self, CoNode* node) {
+        CoRecv* recv = static_cast<CoRecv*>(self);
+        return coChannelDone(
+            recv->channel.recv(recv->value, {&CoScheduler::wakeNode, node}), node);
+    }
+};
+
+} // namespace ESPLooper
+
+#endif // __cpp_impl_coroutine
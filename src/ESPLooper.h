@@ -10,6 +10,7 @@
 #include "Looper.h"
 #include "AutoTask.h"
 #include "OriginalAPI.h"
+#include "Coroutine.h"
 
 // Usage example with auto-registration:
 // 
@@ -1,16 +1,29 @@
 #include "Event.h"
 #include "Looper.h"
+#include <algorithm>
+#include <esp_attr.h>
+#include <memory>
+#include <new>
 #include <string.h>
 
 namespace ESPLooper {
 
 // ===== Event Implementation =====
 
-Event::Event(uint32_t id, void *data, size_t size, bool copyData)
+// In IRAM because sendFromISR constructs events (the heap branch is never
+// taken there)
+IRAM_ATTR Event::Event(uint32_t id, void *data, size_t size, bool copyData)
     : id(id), data(data), dataSize(size), source(xTaskGetCurrentTaskHandle()),
-      ownsData(copyData) {
+      ownsData(copyData), payloadPool(nullptr), refCount(1), homeCore(0),
+      ownerCore(0), routed(true), next(nullptr) {
 
   if (copyData && data && size > 0) {
+    if (size <= INLINE_SIZE) {
+      memcpy(inlineData, data, size);
+      this->data = inlineData;
+      return;
+    }
+
     this->data = malloc(size);
     if (this->data) {
       memcpy(this->data, data, size);
@@ -22,23 +35,39 @@ Event::Event(uint32_t id, void *data, size_t size, bool copyData)
 }
 
 Event::~Event() {
-  if (ownsData && data) {
-    free(data);
+  if (ownsData && data && !isInline()) {
+    if (payloadPool) {
+      payloadPool->release(data);
+    } else {
+      free(data);
+    }
     data = nullptr;
   }
 }
 
 Event::Event(Event &&other) noexcept
     : id(other.id), data(other.data), dataSize(other.dataSize),
-      source(other.source), ownsData(other.ownsData) {
+      source(other.source), ownsData(other.ownsData),
+      payloadPool(other.payloadPool), buffer(std::move(other.buffer)),
+      refCount(1), homeCore(other.homeCore), ownerCore(other.ownerCore),
+      routed(other.routed), next(nullptr) {
+  if (other.isInline()) {
+    memcpy(inlineData, other.inlineData, dataSize);
+    data = inlineData;
+  }
   other.data = nullptr;
   other.ownsData = false;
+  other.payloadPool = nullptr;
 }
 
 Event &Event::operator=(Event &&other) noexcept {
   if (this != &other) {
-    if (ownsData && data) {
-      free(data);
+    if (ownsData && data && !isInline()) {
+      if (payloadPool) {
+        payloadPool->release(data);
+      } else {
+        free(data);
+      }
     }
 
     id = other.id;
@@ -46,28 +75,190 @@ Event &Event::operator=(Event &&other) noexcept {
     dataSize = other.dataSize;
     source = other.source;
     ownsData = other.ownsData;
+    payloadPool = other.payloadPool;
+    buffer = std::move(other.buffer);
+    homeCore = other.homeCore;
+    ownerCore = other.ownerCore;
+    routed = other.routed;
+
+    if (other.isInline()) {
+      memcpy(inlineData, other.inlineData, dataSize);
+      data = inlineData;
+    }
 
     other.data = nullptr;
     other.ownsData = false;
+    other.payloadPool = nullptr;
   }
   return *this;
 }
 
+// ===== Listener Table =====
+
+struct EventBus::BatchListener {
+  uint32_t handle;
+  BatchCallback callback;
+  BatchOptions options;
+
+  // Each dispatcher collects into its own buffer, so no locking is needed
+  struct Pending {
+    std::vector<Event *> events;
+    TickType_t since; // Arrival of the oldest held event
+  } pending[CORE_COUNT];
+
+  BatchListener(uint32_t handle, BatchCallback callback, BatchOptions options)
+      : handle(handle), callback(std::move(callback)), options(options) {
+    if (this->options.maxBatch == 0) {
+      this->options.maxBatch = 1;
+    }
+    for (auto &buffer : pending) {
+      buffer.events.reserve(this->options.maxBatch);
+    }
+  }
+
+  ~BatchListener() {
+    // Unsubscribed with events still held - drop them
+    for (auto &buffer : pending) {
+      for (Event *event : buffer.events) {
+        EventBus::getInstance().releaseEvent(event);
+      }
+    }
+  }
+
+  void add(const Event &event, size_t core) {
+    Pending &buffer = pending[core];
+    if (buffer.events.empty()) {
+      buffer.since = xTaskGetTickCount();
+    }
+    buffer.events.push_back(EventBus::getInstance().retainEvent(event));
+    if (buffer.events.size() >= options.maxBatch) {
+      flush(core);
+    }
+  }
+
+  void flush(size_t core) {
+    Pending &buffer = pending[core];
+    if (callback) {
+      callback(EventSpan(buffer.events.data(), buffer.events.size()));
+    }
+    for (Event *event : buffer.events) {
+      EventBus::getInstance().releaseEvent(event);
+    }
+    buffer.events.clear();
+  }
+};
+
+struct EventBus::ListenerTable {
+  // Sorted by event ID (registration order within an ID); parallel arrays
+  // keep the binary search on a compact key array
+  std::vector<uint32_t> eventIds;
+  std::vector<uint32_t> handles;
+  std::vector<EventCallback> callbacks;
+  std::vector<uint8_t> cores; // Pinned core or ANY_CORE
+  std::vector<BatchListener *> batches; // Non-null for onBatch() entries
+
+  // Owns the onBatch() listeners referenced by `batches`
+  std::vector<std::shared_ptr<BatchListener>> batchListeners;
+
+  std::vector<uint32_t> globalHandles;
+  std::vector<EventCallback> globalCallbacks;
+  std::vector<uint8_t> globalCores;
+
+  size_t lowerBound(uint32_t eventId) const {
+    return std::lower_bound(eventIds.begin(), eventIds.end(), eventId) -
+           eventIds.begin();
+  }
+
+  size_t upperBound(uint32_t eventId) const {
+    return std::upper_bound(eventIds.begin(), eventIds.end(), eventId) -
+           eventIds.begin();
+  }
+
+  // Remove entries [first, last)
+  void erase(size_t first, size_t last) {
+    eventIds.erase(eventIds.begin() + first, eventIds.begin() + last);
+    handles.erase(handles.begin() + first, handles.begin() + last);
+    callbacks.erase(callbacks.begin() + first, callbacks.begin() + last);
+    cores.erase(cores.begin() + first, cores.begin() + last);
+    batches.erase(batches.begin() + first, batches.begin() + last);
+  }
+
+  void eraseGlobal(size_t index) {
+    globalHandles.erase(globalHandles.begin() + index);
+    globalCallbacks.erase(globalCallbacks.begin() + index);
+    globalCores.erase(globalCores.begin() + index);
+  }
+
+  // Drop every entry; vectors keep their capacity for the next edit
+  void clear() {
+    erase(0, eventIds.size());
+    batchListeners.clear();
+    globalHandles.clear();
+    globalCallbacks.clear();
+    globalCores.clear();
+  }
+
+  // Drop batch listeners whose last entry was removed
+  void pruneBatches() {
+    batchListeners.erase(
+        std::remove_if(batchListeners.begin(), batchListeners.end(),
+                       [this](const std::shared_ptr<BatchListener> &batch) {
+                         return std::find(batches.begin(), batches.end(),
+                                          batch.get()) == batches.end();
+                       }),
+        batchListeners.end());
+  }
+};
+
 // ===== EventBus Implementation =====
 
-EventBus::EventBus() {
-  eventQueue = xQueueCreate(EVENT_QUEUE_SIZE, sizeof(Event *));
-  listenersMutex = xSemaphoreCreateMutex();
+EventBus *EventBus::isrBus = nullptr;
 
-  if (!eventQueue || !listenersMutex) {
+EventBus::EventBus()
+    : conflatedIds(0), coalescedEvents(0), perCoreDispatch(false),
+      laneScheduling(LaneScheduling::Strict), laneWeights{8, 4, 1},
+      dispatchMode(DispatchMode::Notify), transport(EventTransport::Queue),
+      crossCoreHops(0), eventPoolExhausted(0), payloadPoolExhausted(0),
+      heapEventAllocs(0), heapPayloadAllocs(0), inlinePayloads(0),
+      bufferPoolExhausted(0), isrDropped(0), nextListenerHandle(1) {
+  listenersMutex = xSemaphoreCreateMutex();
+  if (!listenersMutex) {
     // Fatal error - can't create event system
     abort();
   }
+
+  for (auto &dispatcher : dispatchers) {
+    dispatcher.handle = nullptr;
+    dispatcher.wakeups = 0;
+    dispatcher.dispatched = 0;
+    dispatcher.flushPending = false;
+    dispatcher.flushAt = 0;
+    for (auto &lane : dispatcher.lanes) {
+      lane.queue = nullptr;
+      lane.sent = 0;
+      lane.dropped = 0;
+    }
+  }
+
+  for (auto &slot : conflationSlots) {
+    slot.eventId = 0;
+  }
+
+  // The other cores' queues are only created by enablePerCoreDispatch()
+  if (!createLanes(dispatchers[0])) {
+    abort();
+  }
+
+  isrBus = this;
 }
 
 EventBus::~EventBus() {
-  if (eventQueue) {
-    vQueueDelete(eventQueue);
+  for (auto &dispatcher : dispatchers) {
+    for (auto &lane : dispatcher.lanes) {
+      if (lane.queue) {
+        vQueueDelete(lane.queue);
+      }
+    }
   }
   if (listenersMutex) {
     vSemaphoreDelete(listenersMutex);
@@ -79,100 +270,899 @@ EventBus &EventBus::getInstance() {
   return instance;
 }
 
-void EventBus::on(uint32_t eventId, EventCallback callback) {
+uint8_t EventBus::pinnedCore(BaseType_t coreId) {
+  return coreId >= 0 && coreId < static_cast<BaseType_t>(CORE_COUNT)
+             ? static_cast<uint8_t>(coreId)
+             : ANY_CORE;
+}
+
+ListenerHandle EventBus::addListener(
+    FunctionRef<void(ListenerTable &, uint32_t)> add) {
+  ListenerHandle handle;
   if (xSemaphoreTake(listenersMutex, portMAX_DELAY)) {
-    listeners[eventId].push_back(callback);
+    ListenerTable *table = listeners.edit();
+    if (table) {
+      handle.value = nextListenerHandle++;
+      add(*table, handle.value);
+      listeners.publish(table);
+    }
     xSemaphoreGive(listenersMutex);
   }
+  return handle;
 }
 
-void EventBus::onAny(EventCallback callback) {
+ListenerHandle EventBus::on(uint32_t eventId, EventCallback callback,
+                            BaseType_t coreId) {
+  return addListener([&](ListenerTable &table, uint32_t handle) {
+    size_t index = table.upperBound(eventId);
+    table.eventIds.insert(table.eventIds.begin() + index, eventId);
+    table.handles.insert(table.handles.begin() + index, handle);
+    table.callbacks.insert(table.callbacks.begin() + index,
+                           std::move(callback));
+    table.cores.insert(table.cores.begin() + index, pinnedCore(coreId));
+    table.batches.insert(table.batches.begin() + index, nullptr);
+  });
+}
+
+ListenerHandle EventBus::onBatch(uint32_t eventId, BatchCallback callback,
+                                 BatchOptions options, BaseType_t coreId) {
+  return onBatch(&eventId, 1, callback, options, coreId);
+}
+
+ListenerHandle EventBus::onBatch(const uint32_t *eventIds, size_t count,
+                                 BatchCallback callback, BatchOptions options,
+                                 BaseType_t coreId) {
+  if (count == 0) {
+    return ListenerHandle();
+  }
+
+  return addListener([&](ListenerTable &table, uint32_t handle) {
+    auto batch = std::make_shared<BatchListener>(handle, std::move(callback),
+                                                 options);
+
+    // One table entry per ID, all sharing the handle and the batch
+    for (size_t i = 0; i < count; i++) {
+      size_t index = table.upperBound(eventIds[i]);
+      table.eventIds.insert(table.eventIds.begin() + index, eventIds[i]);
+      table.handles.insert(table.handles.begin() + index, handle);
+      table.callbacks.insert(table.callbacks.begin() + index, nullptr);
+      table.cores.insert(table.cores.begin() + index, pinnedCore(coreId));
+      table.batches.insert(table.batches.begin() + index, batch.get());
+    }
+    table.batchListeners.push_back(batch);
+  });
+}
+
+ListenerHandle EventBus::onAny(EventCallback callback, BaseType_t coreId) {
+  return addListener([&](ListenerTable &table, uint32_t handle) {
+    table.globalHandles.push_back(handle);
+    table.globalCallbacks.push_back(std::move(callback));
+    table.globalCores.push_back(pinnedCore(coreId));
+  });
+}
+
+void EventBus::off(ListenerHandle handle) {
+  if (!handle) {
+    return;
+  }
+
   if (xSemaphoreTake(listenersMutex, portMAX_DELAY)) {
-    globalListeners.push_back(callback);
+    const ListenerTable &current = listeners.current();
+    auto it = std::find(current.handles.begin(), current.handles.end(),
+                        handle.value);
+    auto git = std::find(current.globalHandles.begin(),
+                         current.globalHandles.end(), handle.value);
+    bool found = it != current.handles.end();
+    bool global = !found && git != current.globalHandles.end();
+    size_t globalIndex = git - current.globalHandles.begin();
+
+    ListenerTable *table = found || global ? listeners.edit() : nullptr;
+    if (table && found) {
+      // onBatch() listeners have one entry per ID under the same handle
+      for (size_t i = table->handles.size(); i-- > 0;) {
+        if (table->handles[i] == handle.value) {
+          table->erase(i, i + 1);
+        }
+      }
+      table->pruneBatches();
+    } else if (table) {
+      table->eraseGlobal(globalIndex);
+    }
+    if (table) {
+      listeners.publish(table);
+    }
     xSemaphoreGive(listenersMutex);
   }
 }
 
 void EventBus::off(uint32_t eventId) {
   if (xSemaphoreTake(listenersMutex, portMAX_DELAY)) {
-    listeners.erase(eventId);
+    const ListenerTable &current = listeners.current();
+    size_t first = current.lowerBound(eventId);
+    size_t last = current.upperBound(eventId);
+
+    ListenerTable *table = first != last ? listeners.edit() : nullptr;
+    if (table) {
+      table->erase(first, last);
+      table->pruneBatches();
+      listeners.publish(table);
+    }
+    xSemaphoreGive(listenersMutex);
+  }
+}
+
+void EventBus::synchronize() {
+  if (isDispatcher(xTaskGetCurrentTaskHandle())) {
+    return;
+  }
+
+  // Tables retired after this point can't hold a listener removed before
+  // the call, so readers that arrive later never extend the wait
+  uint32_t epoch = 0;
+  bool done = true;
+  if (xSemaphoreTake(listenersMutex, portMAX_DELAY)) {
+    epoch = listeners.epoch();
+    done = listeners.collect(epoch);
     xSemaphoreGive(listenersMutex);
   }
+  while (!done) {
+    vTaskDelay(1);
+    if (xSemaphoreTake(listenersMutex, portMAX_DELAY)) {
+      done = listeners.collect(epoch);
+      xSemaphoreGive(listenersMutex);
+    }
+  }
+}
+
+bool EventBus::configurePool(size_t eventCount, size_t payloadCount,
+                             size_t payloadSize) {
+  if (!eventPool.begin(sizeof(Event), eventCount)) {
+    return false;
+  }
+
+  // Payload blocks are optional: without them only by-reference and
+  // empty events can be pooled
+  if (payloadCount > 0 && !payloadPool.begin(payloadSize, payloadCount)) {
+    return false;
+  }
+  return true;
+}
+
+Event *EventBus::createEvent(uint32_t eventId, void *data, size_t dataSize,
+                             bool copyData) {
+  bool fitsInline = copyData && data && dataSize > 0 &&
+                    dataSize <= Event::INLINE_SIZE;
+  if (fitsInline) {
+    inlinePayloads.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  if (!eventPool.isEnabled()) {
+    Event *event = new Event(eventId, data, dataSize, copyData);
+    heapEventAllocs.fetch_add(1, std::memory_order_relaxed);
+    if (event->ownsData && !event->isInline()) {
+      heapPayloadAllocs.fetch_add(1, std::memory_order_relaxed);
+    }
+    return event;
+  }
+
+  void *slot = eventPool.acquire();
+  if (!slot) {
+    eventPoolExhausted.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+  }
+
+  Event *event = new (slot) Event(eventId, data, dataSize, fitsInline);
+
+  if (copyData && data && dataSize > 0 && !fitsInline) {
+    void *block = dataSize <= payloadPool.getBlockSize() ? payloadPool.acquire()
+                                                         : nullptr;
+    if (!block) {
+      payloadPoolExhausted.fetch_add(1, std::memory_order_relaxed);
+      destroyEvent(event);
+      return nullptr;
+    }
+
+    memcpy(block, data, dataSize);
+    event->data = block;
+    event->ownsData = true;
+    event->payloadPool = &payloadPool;
+  }
+
+  return event;
+}
+
+void EventBus::destroyEvent(Event *event) {
+  if (eventPool.owns(event)) {
+    event->~Event();
+    eventPool.release(event);
+  } else if (isrPool.owns(event)) {
+    event->~Event();
+    isrPool.release(event);
+  } else {
+    delete event;
+  }
+}
+
+bool EventBus::setTransport(EventTransport newTransport) {
+  if (newTransport == transport) {
+    return true;
+  }
+  if (getQueuedEvents() > 0) {
+    return false;
+  }
+  if (newTransport == EventTransport::Ring) {
+    for (auto &dispatcher : dispatchers) {
+      for (auto &lane : dispatcher.lanes) {
+        if (lane.queue && !lane.ring.isEnabled() &&
+            !lane.ring.begin(EVENT_QUEUE_SIZE)) {
+          return false;
+        }
+      }
+    }
+  }
+
+  transport = newTransport;
+  return true;
+}
+
+bool EventBus::createLanes(Dispatcher &dispatcher) {
+  for (auto &lane : dispatcher.lanes) {
+    if (!lane.queue) {
+      lane.queue = xQueueCreate(EVENT_QUEUE_SIZE, sizeof(Event *));
+    }
+    if (!lane.queue) {
+      return false;
+    }
+    if (transport == EventTransport::Ring && !lane.ring.isEnabled() &&
+        !lane.ring.begin(EVENT_QUEUE_SIZE)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool EventBus::enablePerCoreDispatch() {
+  if (perCoreDispatch) {
+    return true;
+  }
+  if (getQueuedEvents() > 0) {
+    return false;
+  }
+  for (auto &dispatcher : dispatchers) {
+    if (!createLanes(dispatcher)) {
+      return false;
+    }
+  }
+
+  perCoreDispatch = true;
+  return true;
+}
+
+uint32_t EventBus::route(Event *event) {
+  uint32_t home = 1u << event->homeCore;
+  uint32_t pinned = 0;
+  bool unpinned = false;
+
+  const ListenerTable *table = listeners.acquire();
+  size_t last = table->upperBound(event->id);
+  for (size_t i = table->lowerBound(event->id); i < last; i++) {
+    if (table->cores[i] == ANY_CORE) {
+      unpinned = true;
+    } else {
+      pinned |= 1u << table->cores[i];
+    }
+  }
+  for (uint8_t core : table->globalCores) {
+    if (core == ANY_CORE) {
+      unpinned = true;
+    } else {
+      pinned |= 1u << core;
+    }
+  }
+  listeners.release(table);
+
+  // Unpinned listeners and the ID's task run where the event was sent,
+  // unless every listener is pinned elsewhere - then skip the home core
+  if (unpinned || !pinned || (pinned & home)) {
+    event->ownerCore = event->homeCore;
+    return pinned | home;
+  }
+  event->ownerCore = __builtin_ctz(pinned);
+  return pinned;
+}
+
+bool EventBus::setConflated(uint32_t eventId, bool conflated) {
+  if (eventId == 0) {
+    return false;
+  }
+
+  if (!conflated) {
+    // Values already held stay in their slot until their ticket is
+    // dispatched; only new sends stop being conflated
+    ConflationSlot *slot = findConflated(eventId);
+    if (slot) {
+      slot->eventId.store(0);
+      conflatedIds.fetch_sub(1);
+    }
+    return true;
+  }
+
+  if (isConflated(eventId)) {
+    return true;
+  }
+  for (auto &slot : conflationSlots) {
+    // Skip freed slots whose last values are still waiting for dispatch
+    uint32_t expected = 0;
+    if (slot.values.drained() &&
+        slot.eventId.compare_exchange_strong(expected, eventId)) {
+      conflatedIds.fetch_add(1);
+      return true;
+    }
+  }
+  return false;
+}
+
+bool EventBus::isConflated(uint32_t eventId) const {
+  return const_cast<EventBus *>(this)->findConflated(eventId) != nullptr;
+}
+
+EventBus::ConflationSlot *EventBus::findConflated(uint32_t eventId) {
+  if (conflatedIds.load(std::memory_order_relaxed) == 0) {
+    return nullptr;
+  }
+  for (auto &slot : conflationSlots) {
+    if (slot.eventId.load(std::memory_order_relaxed) == eventId) {
+      return &slot;
+    }
+  }
+  return nullptr;
+}
+
+bool EventBus::post(Event *event, EventPriority priority) {
+  event->homeCore = xPortGetCoreID();
+  if (!perCoreDispatch) {
+    return enqueue(event, priority, 0);
+  }
+
+  return fanOut(event, priority, route(event));
+}
+
+bool EventBus::fanOut(Event *event, EventPriority priority, uint32_t cores) {
+  // One reference per target dispatcher, taken before any of them can run
+  event->refCount.store(__builtin_popcount(cores), std::memory_order_relaxed);
+  bool queued = true;
+  while (cores) {
+    size_t core = __builtin_ctz(cores);
+    cores &= cores - 1;
+    queued = enqueue(event, priority, core) && queued;
+  }
+  return queued;
+}
+
+Event *EventBus::retainEvent(const Event &event) {
+  event.refCount.fetch_add(1, std::memory_order_relaxed);
+  return const_cast<Event *>(&event);
+}
+
+void EventBus::releaseEvent(Event *event) {
+  if (event &&
+      event->refCount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    destroyEvent(event);
+  }
+}
+
+size_t EventBus::sendBatch(const BatchEvent *events, size_t count,
+                           EventPriority priority) {
+  // Link the events into one chain per target core; each chain takes a
+  // single queue slot. Events for several cores go through fanOut().
+  Event *heads[CORE_COUNT] = {};
+  Event *tails[CORE_COUNT] = {};
+  size_t lengths[CORE_COUNT] = {};
+  uint8_t home = xPortGetCoreID();
+  size_t queued = 0;
+
+  for (size_t i = 0; i < count; i++) {
+    const BatchEvent &entry = events[i];
+    Event *event =
+        createEvent(entry.id, entry.data, entry.dataSize, entry.copyData);
+    if (!event) {
+      continue;
+    }
+    event->homeCore = home;
+
+    // Conflated IDs and events for several cores can't join a chain
+    uint32_t cores = perCoreDispatch ? route(event) : 1;
+    if ((cores & (cores - 1)) || findConflated(event->id)) {
+      queued += fanOut(event, priority, cores) ? 1 : 0;
+      continue;
+    }
+    size_t core = __builtin_ctz(cores);
+
+    if (tails[core]) {
+      tails[core]->next = event;
+    } else {
+      heads[core] = event;
+    }
+    tails[core] = event;
+    lengths[core]++;
+  }
+
+  for (size_t core = 0; core < CORE_COUNT; core++) {
+    if (heads[core] &&
+        enqueue(heads[core], priority, core, QUEUE_TIMEOUT, lengths[core])) {
+      queued += lengths[core];
+    }
+  }
+  return queued;
+}
+
+bool EventBus::enqueue(Event *event, EventPriority priority, size_t core,
+                       TickType_t timeout, size_t count) {
+  Lane &lane = dispatchers[core].lanes[static_cast<size_t>(priority)];
+  Event *entry = event;
+  bool queued;
+
+  ConflationSlot *slot = event->next ? nullptr : findConflated(event->id);
+  if (slot) {
+    Event *stale = slot->values.offer(core, event);
+    if (stale) {
+      // A ticket for this ID is already queued; it will pick up this value
+      coalescedEvents.fetch_add(1, std::memory_order_relaxed);
+      releaseEvent(stale);
+      return true;
+    }
+    entry = reinterpret_cast<Event *>(reinterpret_cast<uintptr_t>(slot) |
+                                      TICKET_TAG);
+  }
+
+  if (transport == EventTransport::Ring) {
+    // Same blocking contract as the queue: retry until the timeout
+    TickType_t start = xTaskGetTickCount();
+    while (!(queued = lane.ring.push(entry)) &&
+           xTaskGetTickCount() - start < timeout) {
+      wakeDispatcher(core);
+      vTaskDelay(1);
+    }
+  } else {
+    queued = xQueueSend(lane.queue, &entry, timeout) == pdTRUE;
+  }
+
+  if (!queued && slot) {
+    // No ticket made it in. Take back our value - but a sender that
+    // replaced it meanwhile has already released it and relies on the
+    // ticket, so try once more for them before dropping theirs.
+    event = slot->values.withdraw(core, event, [&] {
+      return transport == EventTransport::Ring
+                 ? lane.ring.push(entry)
+                 : xQueueSend(lane.queue, &entry, 0) == pdTRUE;
+    });
+    queued = event == nullptr;
+  }
+
+  if (!queued) {
+    lane.dropped.fetch_add(count, std::memory_order_relaxed);
+    while (event) {
+      Event *next = event->next;
+      event->next = nullptr;
+      releaseEvent(event);
+      event = next;
+    }
+    return false;
+  }
+
+  lane.sent.fetch_add(count, std::memory_order_relaxed);
+  wakeDispatcher(core);
+  return true;
+}
+
+bool EventBus::dequeue(Dispatcher &dispatcher, size_t lane, Event *&event) {
+  if (transport == EventTransport::Ring) {
+    return dispatcher.lanes[lane].ring.pop(event);
+  }
+  return xQueueReceive(dispatcher.lanes[lane].queue, &event, 0) == pdTRUE;
 }
 
 bool EventBus::send(uint32_t eventId, void *data, size_t dataSize,
-                    bool copyData) {
-  Event *event = new Event(eventId, data, dataSize, copyData);
+                    bool copyData, EventPriority priority) {
+  Event *event = createEvent(eventId, data, dataSize, copyData);
   if (!event) {
     return false;
   }
 
-  if (xQueueSend(eventQueue, &event, QUEUE_TIMEOUT) != pdTRUE) {
-    delete event;
+  return post(event, priority);
+}
+
+bool EventBus::configureISRSlots(size_t count) {
+  return isrPool.begin(sizeof(Event), count);
+}
+
+bool IRAM_ATTR EventBus::sendFromISR(uint32_t eventId, void *data,
+                                     size_t dataSize, bool copyData,
+                                     EventPriority priority,
+                                     BaseType_t *higherPriorityTaskWoken) {
+  if (copyData && dataSize > Event::INLINE_SIZE) {
+    isrDropped.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  void *slot = isrPool.acquire();
+  if (!slot) {
+    isrDropped.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  Event *event = new (slot) Event(eventId, data, dataSize, copyData);
+  event->source = nullptr;
+
+  // Routing needs the listener table, which lives in flash: queue on this
+  // core and let its dispatcher fan the event out
+  event->homeCore = xPortGetCoreID();
+  event->routed = !perCoreDispatch;
+
+  Dispatcher &dispatcher = dispatchers[perCoreDispatch ? event->homeCore : 0];
+  Lane &lane = dispatcher.lanes[static_cast<size_t>(priority)];
+  bool queued;
+  BaseType_t woken = pdFALSE;
+  if (transport == EventTransport::Ring) {
+    queued = lane.ring.push(event);
+  } else {
+    queued = xQueueSendFromISR(lane.queue, &event, &woken) == pdTRUE;
+  }
+
+  if (!queued) {
+    // Payload is inline or borrowed, so only the slot needs returning
+    isrPool.release(slot);
+    isrDropped.fetch_add(1, std::memory_order_relaxed);
+    lane.dropped.fetch_add(1, std::memory_order_relaxed);
     return false;
   }
+  lane.sent.fetch_add(1, std::memory_order_relaxed);
+
+  if (dispatchMode == DispatchMode::Notify && dispatcher.handle) {
+    vTaskNotifyGiveFromISR(dispatcher.handle, &woken);
+  }
 
+  if (higherPriorityTaskWoken) {
+    *higherPriorityTaskWoken |= woken;
+  } else if (woken) {
+    portYIELD_FROM_ISR();
+  }
   return true;
 }
 
+bool EventBus::configureBuffers(size_t count, size_t size) {
+  return bufferPool.begin(BufferRef::blockSizeFor(size), count);
+}
+
+BufferRef EventBus::loan(size_t size) {
+  BufferRef buffer;
+  if (bufferPool.isEnabled() &&
+      BufferRef::blockSizeFor(size) <= bufferPool.getBlockSize()) {
+    buffer = BufferRef::acquire(bufferPool);
+  }
+
+  if (!buffer) {
+    bufferPoolExhausted.fetch_add(1, std::memory_order_relaxed);
+  }
+  return buffer;
+}
+
+bool EventBus::publish(uint32_t eventId, BufferRef buffer, size_t dataSize,
+                       EventPriority priority) {
+  if (!buffer || dataSize > buffer.capacity()) {
+    return false;
+  }
+
+  Event *event = createEvent(eventId, buffer.data(), dataSize, false);
+  if (!event) {
+    return false;
+  }
+
+  event->buffer = std::move(buffer);
+  return post(event, priority);
+}
+
 bool EventBus::broadcast(uint32_t eventId, void *data, size_t dataSize) {
   return send(eventId, data, dataSize, true);
 }
 
-void EventBus::processEvents() {
+void EventBus::processEvents(BaseType_t core) {
+  size_t self = perCoreDispatch && core >= 0 &&
+                        core < static_cast<BaseType_t>(CORE_COUNT)
+                    ? core
+                    : 0;
+  Dispatcher &dispatcher = dispatchers[self];
   Event *event = nullptr;
 
-  // Process all pending events
-  while (xQueueReceive(eventQueue, &event, 0) == pdTRUE) {
-    if (event) {
-      dispatchEvent(*event);
-      delete event;
+  auto deliver = [&](size_t lane) {
+    // A conflated ID's ticket: dispatch the latest value of its slot
+    if (reinterpret_cast<uintptr_t>(event) & TICKET_TAG) {
+      auto *slot = reinterpret_cast<ConflationSlot *>(
+          reinterpret_cast<uintptr_t>(event) & ~TICKET_TAG);
+      event = slot->values.take(self);
+    }
+
+    // A sendBatch() chain arrives as one queue entry
+    while (event) {
+      Event *next = event->next;
+      event->next = nullptr;
+
+      if (!event->routed) {
+        // Queued from an ISR on this core: hand it to the other cores first
+        event->routed = true;
+        uint32_t others = route(event) & ~(1u << self);
+        while (others) {
+          size_t target = __builtin_ctz(others);
+          others &= others - 1;
+          retainEvent(*event);
+          enqueue(event, static_cast<EventPriority>(lane), target, 0);
+        }
+      }
+      if (event->homeCore != xPortGetCoreID()) {
+        crossCoreHops.fetch_add(1, std::memory_order_relaxed);
+      }
+      dispatchEvent(*event, self);
+      releaseEvent(event);
+      dispatcher.dispatched.fetch_add(1, std::memory_order_relaxed);
+
+      event = next;
+    }
+  };
+
+  if (laneScheduling == LaneScheduling::Strict) {
+    // Restart from the top lane after every event so a burst of low
+    // priority traffic never delays a newly arrived urgent event
+    size_t lane = 0;
+    while (lane < LANE_COUNT) {
+      if (dequeue(dispatcher, lane, event)) {
+        if (event) {
+          deliver(lane);
+        }
+        lane = 0;
+      } else {
+        lane++;
+      }
+    }
+  } else {
+    // Weighted round-robin until every lane is empty
+    bool progress = true;
+    while (progress) {
+      progress = false;
+      for (size_t lane = 0; lane < LANE_COUNT; lane++) {
+        for (uint8_t n = 0;
+             n < laneWeights[lane] && dequeue(dispatcher, lane, event); n++) {
+          if (event) {
+            deliver(lane);
+          }
+          progress = true;
+        }
+      }
+    }
+  }
+
+  // The queues are drained: hand out what batch listeners have collected
+  flushBatches(self);
+}
+
+void EventBus::flushBatches(size_t core) {
+  Dispatcher &dispatcher = dispatchers[core];
+  TickType_t now = xTaskGetTickCount();
+  dispatcher.flushPending = false;
+
+  const ListenerTable *table = listeners.acquire();
+  for (const auto &batch : table->batchListeners) {
+    BatchListener::Pending &buffer = batch->pending[core];
+    if (buffer.events.empty()) {
+      continue;
+    }
+
+    TickType_t wait = pdMS_TO_TICKS(batch->options.maxWaitMs);
+    TickType_t held = now - buffer.since;
+    if (held >= wait) {
+      batch->flush(core);
+      continue;
+    }
+
+    // Keep holding; wake up in time for the oldest event's deadline
+    TickType_t due = buffer.since + wait;
+    if (!dispatcher.flushPending ||
+        static_cast<int32_t>(due - dispatcher.flushAt) < 0) {
+      dispatcher.flushAt = due;
+      dispatcher.flushPending = true;
     }
   }
+  listeners.release(table);
 }
 
-void EventBus::dispatchEvent(Event &event) {
-  if (xSemaphoreTake(listenersMutex, portMAX_DELAY)) {
-    // First, send to specific task if event ID matches a task
+void EventBus::setLaneScheduling(LaneScheduling scheduling,
+                                 const uint8_t *weights) {
+  if (weights) {
+    for (size_t lane = 0; lane < LANE_COUNT; lane++) {
+      laneWeights[lane] = weights[lane] > 0 ? weights[lane] : 1;
+    }
+  }
+  laneScheduling = scheduling;
+}
+
+void EventBus::waitForEvents(BaseType_t core) {
+  Dispatcher &dispatcher =
+      dispatchers[perCoreDispatch && core >= 0 &&
+                          core < static_cast<BaseType_t>(CORE_COUNT)
+                      ? core
+                      : 0];
+  if (dispatchMode == DispatchMode::Poll || !dispatcher.handle) {
+    vTaskDelay(pdMS_TO_TICKS(1));
+  } else {
+    // Every send() gives one notification; take them all at once since
+    // processEvents() drains the whole queue anyway. Held batches bound
+    // the sleep so they go out on time.
+    TickType_t timeout = portMAX_DELAY;
+    if (dispatcher.flushPending) {
+      TickType_t left = dispatcher.flushAt - xTaskGetTickCount();
+      timeout = static_cast<int32_t>(left) > 0 ? left : 0;
+    }
+    ulTaskNotifyTake(pdTRUE, timeout);
+  }
+  dispatcher.wakeups = dispatcher.wakeups + 1;
+}
+
+void EventBus::setDispatcher(TaskHandle_t handle, BaseType_t core) {
+  if (core >= 0 && core < static_cast<BaseType_t>(CORE_COUNT)) {
+    dispatchers[core].handle = handle;
+  }
+}
+
+bool EventBus::isDispatcher(TaskHandle_t handle) const {
+  for (const auto &dispatcher : dispatchers) {
+    if (dispatcher.handle && dispatcher.handle == handle) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void EventBus::setDispatchMode(DispatchMode mode) {
+  dispatchMode = mode;
+
+  // Kick the dispatchers so they re-read the mode instead of staying parked
+  for (auto &dispatcher : dispatchers) {
+    if (dispatcher.handle) {
+      xTaskNotifyGive(dispatcher.handle);
+    }
+  }
+}
+
+void EventBus::wakeDispatcher(size_t core) {
+  TaskHandle_t handle = dispatchers[core].handle;
+  if (dispatchMode == DispatchMode::Notify && handle) {
+    xTaskNotifyGive(handle);
+  }
+}
+
+void EventBus::dispatchEvent(Event &event, size_t core) {
+  // With per-core dispatch every dispatcher that received the event runs
+  // only the listeners that belong to its core
+  bool perCore = perCoreDispatch;
+  auto runsHere = [&](uint8_t pinned) {
+    return !perCore || (pinned == ANY_CORE ? event.homeCore : pinned) == core;
+  };
+
+  // First, send to specific task if event ID matches a task
+  if (!perCore || event.ownerCore == core) {
     auto &looper = Looper::getInstance();
     auto task = looper.getTask(event.id);
     if (task && task->hasEvents()) {
       looper.executeTaskWithEvent(task, event);
     }
+  }
 
-    // Call specific listeners
-    auto it = listeners.find(event.id);
-    if (it != listeners.end()) {
-      for (auto &callback : it->second) {
-        callback(event);
-      }
-    }
+  // Listeners may call on()/off() from their callbacks - they edit a copy,
+  // this snapshot stays valid until release()
+  const ListenerTable *table = listeners.acquire();
 
-    // Call global listeners
-    for (auto &callback : globalListeners) {
-      callback(event);
+  // Call specific listeners
+  size_t last = table->upperBound(event.id);
+  for (size_t i = table->lowerBound(event.id); i < last; i++) {
+    if (!runsHere(table->cores[i])) {
+      continue;
     }
+    if (table->batches[i]) {
+      table->batches[i]->add(event, core);
+    } else {
+      table->callbacks[i](event);
+    }
+  }
 
-    xSemaphoreGive(listenersMutex);
+  // Call global listeners
+  for (size_t i = 0; i < table->globalCallbacks.size(); i++) {
+    if (runsHere(table->globalCores[i])) {
+      table->globalCallbacks[i](event);
+    }
   }
+
+  listeners.release(table);
 }
 
 size_t EventBus::getQueuedEvents() const {
-  return uxQueueMessagesWaiting(eventQueue);
+  size_t count = 0;
+  for (size_t lane = 0; lane < LANE_COUNT; lane++) {
+    count += getLaneStats(static_cast<EventPriority>(lane)).depth;
+  }
+  return count;
+}
+
+EventBus::LaneStats EventBus::getLaneStats(EventPriority priority) const {
+  LaneStats stats = {0, 0, 0};
+  for (const auto &dispatcher : dispatchers) {
+    const Lane &lane = dispatcher.lanes[static_cast<size_t>(priority)];
+    if (!lane.queue) {
+      continue;
+    }
+    stats.depth += transport == EventTransport::Ring
+                       ? lane.ring.size()
+                       : uxQueueMessagesWaiting(lane.queue);
+    stats.sent += lane.sent.load(std::memory_order_relaxed);
+    stats.dropped += lane.dropped.load(std::memory_order_relaxed);
+  }
+  return stats;
+}
+
+EventBus::CoreStats EventBus::getCoreStats(BaseType_t core) const {
+  CoreStats stats = {0, 0, 0};
+  if (core < 0 || core >= static_cast<BaseType_t>(CORE_COUNT)) {
+    return stats;
+  }
+
+  const Dispatcher &dispatcher = dispatchers[core];
+  for (const auto &lane : dispatcher.lanes) {
+    if (lane.queue) {
+      stats.depth += transport == EventTransport::Ring
+                         ? lane.ring.size()
+                         : uxQueueMessagesWaiting(lane.queue);
+    }
+  }
+  stats.dispatched = dispatcher.dispatched.load(std::memory_order_relaxed);
+  stats.wakeups = dispatcher.wakeups;
+  return stats;
 }
 
 size_t EventBus::getListenerCount(uint32_t eventId) const {
   size_t count = 0;
   if (xSemaphoreTake(listenersMutex, portMAX_DELAY)) {
-    auto it = listeners.find(eventId);
-    if (it != listeners.end()) {
-      count = it->second.size();
-    }
+    const ListenerTable &table = listeners.current();
+    count = table.upperBound(eventId) - table.lowerBound(eventId);
     xSemaphoreGive(listenersMutex);
   }
   return count;
 }
 
+EventBus::Stats EventBus::getStats() const {
+  Stats stats;
+  stats.dispatcherWakeups = 0;
+  for (const auto &dispatcher : dispatchers) {
+    stats.dispatcherWakeups += dispatcher.wakeups;
+  }
+  stats.eventPoolExhausted = eventPoolExhausted.load(std::memory_order_relaxed);
+  stats.payloadPoolExhausted =
+      payloadPoolExhausted.load(std::memory_order_relaxed);
+  stats.heapEventAllocs = heapEventAllocs.load(std::memory_order_relaxed);
+  stats.heapPayloadAllocs = heapPayloadAllocs.load(std::memory_order_relaxed);
+  stats.inlinePayloads = inlinePayloads.load(std::memory_order_relaxed);
+  stats.bufferPoolExhausted =
+      bufferPoolExhausted.load(std::memory_order_relaxed);
+  stats.isrDropped = isrDropped.load(std::memory_order_relaxed);
+  stats.crossCoreHops = crossCoreHops.load(std::memory_order_relaxed);
+  stats.coalescedEvents = coalescedEvents.load(std::memory_order_relaxed);
+  stats.bufferPoolInUse = bufferPool.getInUse();
+  stats.bufferPoolCapacity = bufferPool.getCapacity();
+  stats.eventPoolInUse = eventPool.getInUse();
+  stats.eventPoolCapacity = eventPool.getCapacity();
+  stats.payloadPoolInUse = payloadPool.getInUse();
+  stats.payloadPoolCapacity = payloadPool.getCapacity();
+  stats.isrSlotCapacity = isrPool.getCapacity();
+  return stats;
+}
+
 // Helper function to get Looper instance
 Looper &getLooperInstance() { return Looper::getInstance(); }
 
@@ -2,18 +2,75 @@
 #include <freertos/FreeRTOS.h>
 #include <freertos/queue.h>
 #include <freertos/semphr.h>
-#include <functional>
+#include <atomic>
 #include <map>
 #include <vector>
+#include "Conflation.h"
+#include "Function.h"
+#include "Pool.h"
+#include "RingBuffer.h"
+#include "Snapshot.h"
+
+// Copied payloads up to this size are stored inside the Event itself.
+// Must be identical for every translation unit - set it via build flags.
+#ifndef LP_EVENT_INLINE_SIZE
+#define LP_EVENT_INLINE_SIZE 24
+#endif
+
+// Number of event IDs that can be conflated at the same time
+#ifndef LP_MAX_CONFLATED_IDS
+#define LP_MAX_CONFLATED_IDS 8
+#endif
 
 namespace ESPLooper {
 
+// How the dispatcher task waits for new events
+enum class DispatchMode {
+    Poll,   // Wake every tick and drain the queue (legacy behaviour)
+    Notify  // Sleep until send() notifies the dispatcher
+};
+
+// What carries Event pointers from send() to the dispatcher
+enum class EventTransport {
+    Queue,  // FreeRTOS queue (takes the queue's critical section per op)
+    Ring    // Lock-free MPSC ring buffer
+};
+
+// Event priority class - each class has its own lane in the EventBus
+enum class EventPriority : uint8_t {
+    High,    // Faults, control - drained first
+    Normal,  // Default
+    Low      // Bulk telemetry
+};
+
+// Order in which processEvents() drains the lanes
+enum class LaneScheduling {
+    Strict,   // Always take from the highest non-empty lane
+    Weighted  // Round-robin, up to laneWeights[i] events per lane per round
+};
+
 struct Event {
     uint32_t id;           // Event ID
     void* data;            // Event data pointer
     size_t dataSize;       // Size of data
     TaskHandle_t source;   // Source task
     bool ownsData;         // Whether this event owns the data
+    BlockPool* payloadPool; // Pool the owned data came from (nullptr = heap)
+    BufferRef buffer;      // Loaned buffer backing data (zero-copy events)
+    mutable std::atomic<uint16_t> refCount; // Holders; managed by EventBus
+    uint8_t homeCore;      // Core the event was sent from
+    uint8_t ownerCore;     // Core whose dispatcher runs the ID's task
+    bool routed;           // Fanned out to its listeners' cores yet
+    Event* next;           // Next event of a sendBatch() chain
+    
+    static constexpr size_t INLINE_SIZE = LP_EVENT_INLINE_SIZE;
+    alignas(8) uint8_t inlineData[INLINE_SIZE]; // Small payload storage
+    
+    bool isInline() const { return data == inlineData; }
+    
+    // Keep a loaned payload alive beyond the callback without copying.
+    // Empty for events that were not published from a loaned buffer.
+    BufferRef share() const { return buffer; }
     
     Event(uint32_t id, void* data = nullptr, size_t size = 0, bool copyData = false);
     ~Event();
@@ -27,47 +84,303 @@ struct Event {
     Event& operator=(Event&& other) noexcept;
 };
 
+// One entry of EventBus::sendBatch()
+struct BatchEvent {
+    uint32_t id;
+    void* data;
+    size_t dataSize;
+    bool copyData;
+};
+
+// Events handed to an onBatch() listener, oldest first. Valid for the
+// duration of the callback; retainEvent() any event you need to keep.
+class EventSpan {
+public:
+    class iterator {
+    public:
+        explicit iterator(Event* const* pos) : pos(pos) {}
+        const Event& operator*() const { return **pos; }
+        const Event* operator->() const { return *pos; }
+        iterator& operator++() { ++pos; return *this; }
+        bool operator!=(const iterator& other) const { return pos != other.pos; }
+    private:
+        Event* const* pos;
+    };
+    
+    EventSpan(Event* const* events, size_t count) : events(events), count(count) {}
+    
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    const Event& operator[](size_t index) const { return *events[index]; }
+    iterator begin() const { return iterator(events); }
+    iterator end() const { return iterator(events + count); }
+    
+private:
+    Event* const* events;
+    size_t count;
+};
+
+// When an onBatch() listener is called
+struct BatchOptions {
+    size_t maxBatch = 32;   // Deliver as soon as this many events are pending
+    uint32_t maxWaitMs = 0; // 0: deliver whenever the queue runs empty;
+                            // otherwise hold events up to this long
+};
+
+// Identifies one subscription; returned by on()/onAny(), accepted by off()
+struct ListenerHandle {
+    uint32_t value = 0;
+    explicit operator bool() const { return value != 0; }
+};
+
 class EventBus {
 public:
-    using EventCallback = std::function<void(const Event&)>;
+    // Stored in place (see Function.h): subscribing never allocates for
+    // the callback itself
+    using EventCallback = InplaceFunction<void(const Event&)>;
+    using BatchCallback = InplaceFunction<void(EventSpan)>;
     
     static EventBus& getInstance();
     
-    // Register listener for specific event
-    void on(uint32_t eventId, EventCallback callback);
+    static constexpr size_t CORE_COUNT = portNUM_PROCESSORS;
+    
+    // Register listener for specific event. With per-core dispatch the
+    // callback runs on `coreId`'s dispatcher (unpinned: the sender's core).
+    ListenerHandle on(uint32_t eventId, EventCallback callback,
+                      BaseType_t coreId = tskNO_AFFINITY);
+    
+    // Register a listener that receives the pending events for one or more
+    // IDs as a span, one call per batch. Held events stay retained (and
+    // occupy their pool slots) until the batch is delivered.
+    ListenerHandle onBatch(uint32_t eventId, BatchCallback callback,
+                           BatchOptions options = BatchOptions(),
+                           BaseType_t coreId = tskNO_AFFINITY);
+    ListenerHandle onBatch(const uint32_t* eventIds, size_t count,
+                           BatchCallback callback,
+                           BatchOptions options = BatchOptions(),
+                           BaseType_t coreId = tskNO_AFFINITY);
     
     // Register global listener (receives all events)
-    void onAny(EventCallback callback);
+    ListenerHandle onAny(EventCallback callback, BaseType_t coreId = tskNO_AFFINITY);
+    
+    // Unregister a single listener
+    void off(ListenerHandle handle);
     
-    // Unregister listener
+    // Unregister every listener for an event ID
     void off(uint32_t eventId);
     
+    // Wait until no dispatcher can still be running a listener removed by
+    // off() before this call. Only the tables replaced so far are waited
+    // for, so steady traffic can't hold it up. Returns immediately when
+    // called from a dispatcher, which may itself be inside such a listener.
+    void synchronize();
+    
     // Send event (thread-safe)
-    bool send(uint32_t eventId, void* data = nullptr, size_t dataSize = 0, bool copyData = false);
+    bool send(uint32_t eventId, void* data = nullptr, size_t dataSize = 0, bool copyData = false,
+              EventPriority priority = EventPriority::Normal);
+    
+    // Send a burst with one queue operation and one dispatcher wake per
+    // target core. Listeners still receive the events one at a time, in
+    // order. Returns the number of events queued.
+    size_t sendBatch(const BatchEvent* events, size_t count,
+                     EventPriority priority = EventPriority::Normal);
+    
+    // Zero-copy send: loan a buffer, fill it in place, publish it.
+    // Listeners see the buffer as event.data and may keep it via share().
+    bool configureBuffers(size_t count, size_t size);
+    BufferRef loan(size_t size);
+    bool publish(uint32_t eventId, BufferRef buffer, size_t dataSize,
+                 EventPriority priority = EventPriority::Normal);
+    
+    // Send from an interrupt handler. Never allocates: the event comes from
+    // a preallocated ISR slot and a copied payload must fit in
+    // Event::INLINE_SIZE. Pass `higherPriorityTaskWoken` to batch the yield
+    // yourself; otherwise the call yields to the dispatcher when needed.
+    bool sendFromISR(uint32_t eventId, void* data = nullptr, size_t dataSize = 0,
+                     bool copyData = true, EventPriority priority = EventPriority::Normal,
+                     BaseType_t* higherPriorityTaskWoken = nullptr);
+    bool configureISRSlots(size_t count);
+    
+    // Last-value conflation for "current state" IDs: a send() replaces the
+    // value still waiting in the queue instead of adding another entry, so
+    // each conflated ID holds at most one queue slot per dispatcher.
+    // Returns false when LP_MAX_CONFLATED_IDS IDs are already conflated.
+    // Not applied to sendFromISR().
+    bool setConflated(uint32_t eventId, bool conflated = true);
+    bool isConflated(uint32_t eventId) const;
+    
+    // Keep a dispatched event alive past its callback (e.g. to hand it to
+    // another task); every retainEvent() needs one releaseEvent()
+    Event* retainEvent(const Event& event);
+    void releaseEvent(Event* event);
+    
+    // IRAM-safe accessor for interrupt handlers (getInstance() lives in
+    // flash and its static guard is not ISR safe); nullptr before first use
+    static EventBus* isrInstance() { return isrBus; }
     
     // Broadcast to all listeners
     bool broadcast(uint32_t eventId, void* data = nullptr, size_t dataSize = 0);
     
-    // Process pending events (called by dispatcher task)
-    void processEvents();
+    // Process pending events (called by dispatcher task; `core` selects
+    // the queue set when per-core dispatch is enabled)
+    void processEvents(BaseType_t core = 0);
+    
+    // Block the dispatcher until new events may be pending
+    void waitForEvents(BaseType_t core = 0);
+    
+    // Preallocate event and payload storage; once enabled, send() never
+    // touches the heap and fails (counted in Stats) when a pool runs dry.
+    // Returns false when either pool could not be allocated.
+    bool configurePool(size_t eventCount, size_t payloadCount, size_t payloadSize);
+    
+    // Select the queue implementation. Only switches while nothing is queued;
+    // call it before traffic starts (Looper::begin does).
+    bool setTransport(EventTransport transport);
+    EventTransport getTransport() const { return transport; }
+    
+    // Lane draining policy; weights are used by LaneScheduling::Weighted
+    void setLaneScheduling(LaneScheduling scheduling, const uint8_t* weights = nullptr);
+    
+    // One queue set and dispatcher per core instead of a single one.
+    // Events are queued on every core with a listener pinned to it, plus
+    // the sender's core for unpinned listeners. Like setTransport(), only
+    // switches while nothing is queued.
+    bool enablePerCoreDispatch();
+    bool isPerCoreDispatch() const { return perCoreDispatch; }
+    
+    // Dispatcher wiring
+    void setDispatcher(TaskHandle_t handle, BaseType_t core = 0);
+    void setDispatchMode(DispatchMode mode);
+    DispatchMode getDispatchMode() const { return dispatchMode; }
     
     // Statistics
+    struct Stats {
+        uint32_t dispatcherWakeups;  // Times the dispatcher woke up to drain
+        uint32_t eventPoolExhausted; // Sends rejected: no free event slot
+        uint32_t payloadPoolExhausted; // Sends rejected: no free/large enough payload block
+        uint32_t heapEventAllocs;    // Events allocated with new
+        uint32_t heapPayloadAllocs;  // Copied payloads allocated with malloc
+        uint32_t inlinePayloads;     // Copied payloads stored inside the Event
+        uint32_t bufferPoolExhausted; // loan() calls that returned no buffer
+        uint32_t isrDropped;         // sendFromISR calls that could not queue
+        uint32_t crossCoreHops;      // Events dispatched on a core other than the sender's
+        uint32_t coalescedEvents;    // Conflated values replaced before dispatch
+        size_t bufferPoolInUse;
+        size_t bufferPoolCapacity;
+        size_t eventPoolInUse;
+        size_t eventPoolCapacity;
+        size_t payloadPoolInUse;
+        size_t payloadPoolCapacity;
+        size_t isrSlotCapacity;
+    };
+    
+    struct LaneStats {
+        size_t depth;      // Queue entries in the lane (a sendBatch() chain is one)
+        uint32_t sent;     // Events accepted into the lane
+        uint32_t dropped;  // Events rejected because the lane was full
+    };
+    
+    struct CoreStats {
+        size_t depth;        // Events queued for this core's dispatcher
+        uint32_t dispatched; // Events this dispatcher has processed
+        uint32_t wakeups;    // Times this dispatcher woke up to drain
+    };
+    
+    static constexpr size_t LANE_COUNT = 3;
+    
     size_t getQueuedEvents() const;
     size_t getListenerCount(uint32_t eventId) const;
+    Stats getStats() const;
+    LaneStats getLaneStats(EventPriority priority) const;
+    CoreStats getCoreStats(BaseType_t core) const;
     
 private:
     EventBus();
     ~EventBus();
     
-    QueueHandle_t eventQueue;
+    struct Lane {
+        QueueHandle_t queue;
+        MpscRing<Event> ring;
+        std::atomic<uint32_t> sent;
+        std::atomic<uint32_t> dropped;
+    };
+    
+    // Queue set drained by one dispatcher task. Only dispatchers[0] is used
+    // unless per-core dispatch is enabled; then dispatchers[i] is core i.
+    struct Dispatcher {
+        Lane lanes[LANE_COUNT];
+        TaskHandle_t handle;
+        volatile uint32_t wakeups;
+        std::atomic<uint32_t> dispatched;
+        bool flushPending;   // A held batch must be delivered at flushAt
+        TickType_t flushAt;
+    };
+    
+    // Last value of a conflated ID, one per dispatcher. The lane carries a
+    // tagged pointer to the slot (a ticket) instead of the event itself.
+    struct ConflationSlot {
+        std::atomic<uint32_t> eventId; // 0 = free
+        LastValueSlot<Event, CORE_COUNT> values;
+    };
+    
+    static constexpr size_t MAX_CONFLATED_IDS = LP_MAX_CONFLATED_IDS;
+    static constexpr uintptr_t TICKET_TAG = 1;
+    
+    Dispatcher dispatchers[CORE_COUNT];
+    ConflationSlot conflationSlots[MAX_CONFLATED_IDS];
+    std::atomic<uint32_t> conflatedIds;
+    std::atomic<uint32_t> coalescedEvents;
+    bool perCoreDispatch;
+    LaneScheduling laneScheduling;
+    uint8_t laneWeights[LANE_COUNT];
     SemaphoreHandle_t listenersMutex;
-    std::map<uint32_t, std::vector<EventCallback>> listeners;
-    std::vector<EventCallback> globalListeners;
+    volatile DispatchMode dispatchMode;
+    EventTransport transport;
+    std::atomic<uint32_t> crossCoreHops;
+    
+    BlockPool eventPool;
+    BlockPool payloadPool;
+    BlockPool bufferPool;
+    BlockPool isrPool;
+    static EventBus* isrBus;
+    std::atomic<uint32_t> eventPoolExhausted;
+    std::atomic<uint32_t> payloadPoolExhausted;
+    std::atomic<uint32_t> heapEventAllocs;
+    std::atomic<uint32_t> heapPayloadAllocs;
+    std::atomic<uint32_t> inlinePayloads;
+    std::atomic<uint32_t> bufferPoolExhausted;
+    std::atomic<uint32_t> isrDropped;
+    
+    // Listener table. on()/off() edit a copy and publish it under
+    // listenersMutex; dispatch pins the current version lock-free.
+    struct ListenerTable;
+    struct BatchListener;
+    Snapshot<ListenerTable> listeners;
+    uint32_t nextListenerHandle;    // Guarded by listenersMutex
     
     static constexpr size_t EVENT_QUEUE_SIZE = 50;
     static constexpr TickType_t QUEUE_TIMEOUT = pdMS_TO_TICKS(100);
     
-    void dispatchEvent(Event& event);
+    static constexpr uint8_t ANY_CORE = 0xFF;
+    static uint8_t pinnedCore(BaseType_t coreId);
+    
+    Event* createEvent(uint32_t eventId, void* data, size_t dataSize, bool copyData);
+    void destroyEvent(Event* event);
+    bool createLanes(Dispatcher& dispatcher);
+    ConflationSlot* findConflated(uint32_t eventId);
+    uint32_t route(Event* event);
+    bool post(Event* event, EventPriority priority);
+    bool fanOut(Event* event, EventPriority priority, uint32_t cores);
+    bool enqueue(Event* event, EventPriority priority, size_t core,
+                 TickType_t timeout = QUEUE_TIMEOUT, size_t count = 1);
+    bool dequeue(Dispatcher& dispatcher, size_t lane, Event*& event);
+    void dispatchEvent(Event& event, size_t core);
+    void flushBatches(size_t core);
+    void wakeDispatcher(size_t core);
+    bool isDispatcher(TaskHandle_t handle) const;
+    
+    // Copy the table, let `add` append entries under a new handle, publish
+    ListenerHandle addListener(FunctionRef<void(ListenerTable&, uint32_t)> add);
 };
 
 // Compile-time string hashing for event IDs
@@ -0,0 +1,181 @@
+#include "Executor.h"
+#include "OriginalAPI.h"
+#include <algorithm>
+
+namespace ESPLooper {
+
+static Executor *workers[portNUM_PROCESSORS] = {};
+
+Executor::Executor()
+    : head(nullptr), cursor(nullptr), lock(portMUX_INITIALIZER_UNLOCKED),
+      handle(nullptr), running(nullptr), taskCount(0), steps(0), passes(0),
+      wakeups(0) {}
+
+bool Executor::createWorkers(UBaseType_t priority, uint32_t stackSize) {
+  for (size_t i = 0; i < portNUM_PROCESSORS; i++) {
+    if (workers[i]) {
+      continue;
+    }
+
+    Executor *worker = new Executor();
+    if (xTaskCreatePinnedToCore(workerTask, "Executor", stackSize, worker,
+                                priority, &worker->handle, i) != pdPASS) {
+      delete worker;
+      return false;
+    }
+    workers[i] = worker;
+  }
+  return true;
+}
+
+Executor *Executor::forCore(BaseType_t coreId) {
+  if (coreId >= 0 && coreId < portNUM_PROCESSORS) {
+    return workers[coreId];
+  }
+
+  // No affinity: balance by queue length
+  Executor *best = nullptr;
+  for (Executor *worker : workers) {
+    if (worker && (!best || worker->taskCount < best->taskCount)) {
+      best = worker;
+    }
+  }
+  return best;
+}
+
+void Executor::attach(CoopTask *task) {
+  ExecNode &node = task->execNode;
+
+  portENTER_CRITICAL(&lock);
+  if (!node.pprev) {
+    node.owner = task;
+    node.next = head;
+    if (head) {
+      head->pprev = &node.next;
+    }
+    node.pprev = &head;
+    head = &node;
+    node.woken = true;
+    taskCount++;
+  }
+  portEXIT_CRITICAL(&lock);
+
+  // The worker may be asleep - even when attaching from one of its own
+  // entries, the pass in progress has already computed its sleep
+  xTaskNotifyGive(handle);
+}
+
+void Executor::detach(CoopTask *task) {
+  ExecNode &node = task->execNode;
+
+  portENTER_CRITICAL(&lock);
+  if (node.pprev) {
+    unlink(&node);
+  }
+  portEXIT_CRITICAL(&lock);
+
+  // The caller may free the task next - don't let its step outlive it
+  if (xTaskGetCurrentTaskHandle() != handle) {
+    while (running == task) {
+      vTaskDelay(1);
+    }
+  }
+}
+
+void Executor::wake(CoopTask *task) {
+  task->execNode.woken = true;
+  xTaskNotifyGive(handle);
+}
+
+void Executor::unlink(ExecNode *node) {
+  if (cursor == node) {
+    cursor = node->next;
+  }
+  *node->pprev = node->next;
+  if (node->next) {
+    node->next->pprev = node->pprev;
+  }
+  node->next = nullptr;
+  node->pprev = nullptr;
+  taskCount--;
+}
+
+void Executor::workerLoop() {
+  while (true) {
+    TickType_t sleep = portMAX_DELAY;
+
+    portENTER_CRITICAL(&lock);
+    cursor = head;
+    while (ExecNode *node = cursor) {
+      cursor = node->next;
+
+      TickType_t now = xTaskGetTickCount();
+      if (!node->woken) {
+        if (node->parked) {
+          continue;
+        }
+        int32_t remaining = static_cast<int32_t>(node->wakeAt - now);
+        if (remaining > 0) {
+          sleep = std::min<TickType_t>(sleep, remaining);
+          continue;
+        }
+      }
+
+      // A wake() from here on lands in the next pass
+      node->woken = false;
+      CoopTask *task = node->owner;
+      running = task;
+      portEXIT_CRITICAL(&lock);
+
+      // detach() from another task waits while `running` is this task, so
+      // it is still here to pin. The pin keeps it alive when the step
+      // removes its own task (detach() doesn't wait on this worker).
+      std::shared_ptr<Task> self;
+      bool alive = task->pin(self);
+      TickType_t next = 0;
+      if (alive) {
+        task->step();
+        next = task->sleepTicks();
+      }
+
+      portENTER_CRITICAL(&lock);
+      running = nullptr;
+      steps++;
+      if (alive && node->pprev) {
+        node->parked = next == portMAX_DELAY;
+        node->wakeAt = xTaskGetTickCount() + next;
+        if (!node->parked) {
+          sleep = std::min(sleep, next);
+        }
+      }
+
+      // Dropping the last reference runs the destructor, which takes the
+      // lock to detach
+      if (self) {
+        portEXIT_CRITICAL(&lock);
+        self.reset();
+        portENTER_CRITICAL(&lock);
+      }
+    }
+    passes++;
+    portEXIT_CRITICAL(&lock);
+
+    ulTaskNotifyTake(pdTRUE, sleep);
+    wakeups++;
+  }
+}
+
+void Executor::workerTask(void *parameter) {
+  static_cast<Executor *>(parameter)->workerLoop();
+}
+
+Executor::Stats Executor::getStats() const {
+  Stats stats;
+  stats.tasks = taskCount;
+  stats.steps = steps;
+  stats.passes = passes;
+  stats.wakeups = wakeups;
+  return stats;
+}
+
+} // namespace ESPLooper
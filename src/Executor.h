@@ -0,0 +1,75 @@
+#pragma once
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <stdint.h>
+
+namespace ESPLooper {
+
+class CoopTask;
+
+// Intrusive run-queue link embedded in every CoopTask
+struct ExecNode {
+    ExecNode* next = nullptr;
+    ExecNode** pprev = nullptr;   // Link pointing at this node; null = not queued
+    CoopTask* owner = nullptr;
+    TickType_t wakeAt = 0;        // Next step due at this tick...
+    bool parked = false;          // ...or only when woken
+    volatile bool woken = false;  // Step on the next pass regardless
+};
+
+// Steps TickerTasks and ThreadTasks cooperatively on one worker task per
+// core instead of one FreeRTOS task each (LooperConfig::threadMode =
+// ThreadMode::Executor).
+//
+// Each worker walks its run queue round-robin, calling step() on every
+// entry that is due, then sleeps until the earliest deadline. Entries
+// parked in LP_WAIT are skipped until wake(). A task's coreId picks the
+// worker; unpinned tasks go to whichever worker has the fewest entries. An
+// entry must return promptly: a blocking callback stalls every other entry
+// on that worker.
+class Executor {
+public:
+    // Workers are created by Looper::begin(), one pinned to each core
+    static bool createWorkers(UBaseType_t priority, uint32_t stackSize);
+
+    // Worker for a task with the given core hint; null before createWorkers()
+    static Executor* forCore(BaseType_t coreId);
+
+    void attach(CoopTask* task);
+
+    // Remove `task` from the run queue. If it is being stepped, waits for
+    // the step to return (unless called from the worker itself).
+    void detach(CoopTask* task);
+
+    // Step `task` on the next pass even if it is sleeping or parked
+    void wake(CoopTask* task);
+
+    struct Stats {
+        size_t tasks;       // Entries on the run queue
+        uint32_t steps;     // step() calls
+        uint32_t passes;    // Full sweeps of the run queue
+        uint32_t wakeups;   // Times the worker woke up
+    };
+    Stats getStats() const;
+    TaskHandle_t getHandle() const { return handle; }
+
+private:
+    Executor();
+
+    ExecNode* head;
+    ExecNode* cursor;             // Next entry of the current pass
+    portMUX_TYPE lock;
+    TaskHandle_t handle;
+    CoopTask* volatile running;   // Task whose step is executing
+    size_t taskCount;
+    uint32_t steps;
+    uint32_t passes;
+    uint32_t wakeups;
+
+    void unlink(ExecNode* node);
+    void workerLoop();
+
+    static void workerTask(void* parameter);
+};
+
+} // namespace ESPLooper
@@ -0,0 +1,163 @@
+#pragma once
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Bytes of captured state an InplaceFunction holds without a capacity
+// argument: a `this` pointer plus a few values, or a whole std::function
+#ifndef LP_FUNCTION_CAPACITY
+#define LP_FUNCTION_CAPACITY (4 * sizeof(void*))
+#endif
+
+namespace ESPLooper {
+
+template <typename Signature, size_t Capacity = LP_FUNCTION_CAPACITY>
+class InplaceFunction;
+
+// Owning callable like std::function, but the target always lives inside
+// the object: constructing, copying and destroying one never allocates. A
+// callable bigger than Capacity is a compile error instead of a silent
+// heap allocation - capture a pointer to the state, or raise the capacity.
+template <typename R, typename... Args, size_t Capacity>
+class InplaceFunction<R(Args...), Capacity> {
+public:
+    InplaceFunction() noexcept : ops(nullptr) {}
+    InplaceFunction(std::nullptr_t) noexcept : ops(nullptr) {}
+
+    template <typename F, typename Fn = typename std::decay<F>::type,
+              typename = typename std::enable_if<
+                  !std::is_same<Fn, InplaceFunction>::value &&
+                  std::is_invocable_r<R, Fn&, Args...>::value>::type>
+    InplaceFunction(F&& f) : ops(nullptr) {
+        static_assert(sizeof(Fn) <= Capacity,
+                      "Callback captures too much for InplaceFunction: "
+                      "capture a pointer instead or raise the capacity");
+        static_assert(alignof(Fn) <= alignof(std::max_align_t),
+                      "Callback is over-aligned for InplaceFunction");
+
+        if constexpr (std::is_pointer<Fn>::value || std::is_member_pointer<Fn>::value) {
+            if (f == nullptr) {
+                return;
+            }
+        }
+        new (storage) Fn(std::forward<F>(f));
+        ops = &Ops<Fn>::table;
+    }
+
+    InplaceFunction(const InplaceFunction& other) : ops(other.ops) {
+        if (ops) {
+            ops->copy(storage, other.storage);
+        }
+    }
+
+    InplaceFunction(InplaceFunction&& other) noexcept : ops(other.ops) {
+        if (ops) {
+            ops->move(storage, other.storage);
+            other.reset();
+        }
+    }
+
+    InplaceFunction& operator=(const InplaceFunction& other) {
+        if (this != &other) {
+            reset();
+            if (other.ops) {
+                other.ops->copy(storage, other.storage);
+                ops = other.ops;
+            }
+        }
+        return *this;
+    }
+
+    InplaceFunction& operator=(InplaceFunction&& other) noexcept {
+        if (this != &other) {
+            reset();
+            if (other.ops) {
+                other.ops->move(storage, other.storage);
+                ops = other.ops;
+                other.reset();
+            }
+        }
+        return *this;
+    }
+
+    InplaceFunction& operator=(std::nullptr_t) noexcept {
+        reset();
+        return *this;
+    }
+
+    ~InplaceFunction() { reset(); }
+
+    // Like std::function, callable through a const reference
+    R operator()(Args... args) const {
+        return ops->invoke(const_cast<unsigned char*>(storage), std::forward<Args>(args)...);
+    }
+
+    explicit operator bool() const { return ops != nullptr; }
+
+private:
+    struct OpsTable {
+        R (*invoke)(void* target, Args&&... args);
+        void (*copy)(void* dst, const void* src);
+        void (*move)(void* dst, void* src);
+        void (*destroy)(void* target);
+    };
+
+    template <typename Fn>
+    struct Ops {
+        static R invoke(void* target, Args&&... args) {
+            return (*static_cast<Fn*>(target))(std::forward<Args>(args)...);
+        }
+        static void copy(void* dst, const void* src) {
+            new (dst) Fn(*static_cast<const Fn*>(src));
+        }
+        static void move(void* dst, void* src) {
+            new (dst) Fn(std::move(*static_cast<Fn*>(src)));
+        }
+        static void destroy(void* target) {
+            static_cast<Fn*>(target)->~Fn();
+        }
+        static constexpr OpsTable table = {&invoke, &copy, &move, &destroy};
+    };
+
+    void reset() {
+        if (ops) {
+            ops->destroy(storage);
+            ops = nullptr;
+        }
+    }
+
+    alignas(std::max_align_t) unsigned char storage[Capacity];
+    const OpsTable* ops;
+};
+
+template <typename Signature>
+class FunctionRef;
+
+// Non-owning reference to a callable, for parameters that are only called
+// before the function returns (e.g. a visitor). Two pointers, no copy of
+// the target; the referenced callable must outlive the FunctionRef.
+template <typename R, typename... Args>
+class FunctionRef<R(Args...)> {
+public:
+    template <typename F, typename Fn = typename std::remove_reference<F>::type,
+              typename = typename std::enable_if<
+                  !std::is_same<typename std::decay<F>::type, FunctionRef>::value &&
+                  std::is_invocable_r<R, Fn&, Args...>::value>::type>
+    FunctionRef(F&& f)
+        : target(const_cast<void*>(static_cast<const void*>(std::addressof(f)))),
+          invoke(&call<Fn>) {}
+
+    R operator()(Args... args) const { return invoke(target, std::forward<Args>(args)...); }
+
+private:
+    template <typename Fn>
+    static R call(void* target, Args&&... args) {
+        return (*static_cast<Fn*>(target))(std::forward<Args>(args)...);
+    }
+
+    void* target;
+    R (*invoke)(void* target, Args&&... args);
+};
+
+} // namespace ESPLooper
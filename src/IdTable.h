@@ -0,0 +1,269 @@
+#pragma once
+#include "Snapshot.h"
+#include <atomic>
+#include <memory>
+#include <new>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace ESPLooper {
+
+// Hash table from a 32-bit ID (EVENT_ID of a name) to an object, read
+// lock-free and without allocating, for the task registry.
+//
+// Open addressing with linear probing. An entry is written into an empty
+// slot and only then marked full, and a removed entry is only marked
+// deleted, so add and remove update the table readers are probing in
+// place. The table is rebuilt - copied into a Snapshot version, which
+// drops the tombstones - only when its used slots reach half of it. The
+// table is sized for three times the live entries, so at least a sixth of
+// it gets filled between rebuilds.
+//
+// Entries hold weak_ptrs: a retired table a slow reader still sees keeps
+// no object alive.
+//
+// find() may run on any task. Writers (insert, erase, reserve, getStats)
+// must be serialized by the owner.
+template <typename T>
+class IdTable {
+public:
+    // Lock-free
+    std::shared_ptr<T> find(uint32_t id) const {
+        std::shared_ptr<T> result;
+        const Table* table = tables.acquire();
+        if (table->size) {
+            for (size_t i = table->home(id);; i = (i + 1) & (table->size - 1)) {
+                const Slot& slot = table->slots[i];
+                State state = slot.state.load(std::memory_order_acquire);
+                if (state == State::Empty) {
+                    break;
+                }
+                if (state == State::Full && slot.id == id) {
+                    result = slot.item.lock();
+                    break;
+                }
+            }
+        }
+        tables.release(table);
+        return result;
+    }
+
+    // Map `id` to `item`. An entry already there is replaced and returned
+    // in `replaced`. False when a rebuild ran out of memory.
+    bool insert(uint32_t id, const std::shared_ptr<T>& item,
+                std::shared_ptr<T>* replaced = nullptr) {
+        const Table& current = tables.current();
+        if ((current.used + 1) * 2 > current.size && !rebuild(current.count + 1)) {
+            return false;
+        }
+
+        Table& table = tables.live();
+        size_t mask = table.size - 1;
+        size_t i = table.home(id);
+        size_t probe = 1;
+        Slot* previous = nullptr;
+        while (true) {
+            Slot& slot = table.slots[i];
+            State state = slot.state.load(std::memory_order_relaxed);
+            if (state == State::Empty) {
+                break;
+            }
+            if (state == State::Full && slot.id == id && !previous) {
+                previous = &slot;
+            }
+            i = (i + 1) & mask;
+            probe++;
+        }
+
+        // Publish the new entry before withdrawing the old one, so a reader
+        // always finds one of them
+        Slot& slot = table.slots[i];
+        slot.id = id;
+        slot.item = item;
+        slot.state.store(State::Full, std::memory_order_release);
+        table.used++;
+        table.count++;
+        if (probe > table.longestProbe) {
+            table.longestProbe = probe;
+        }
+
+        if (previous) {
+            if (replaced) {
+                *replaced = previous->item.lock();
+            }
+            previous->state.store(State::Deleted, std::memory_order_release);
+            table.count--;
+        }
+        return true;
+    }
+
+    // Remove the entry for `id` if it is `item`. Returns whether it was.
+    bool erase(uint32_t id, const T* item) {
+        Table& table = tables.live();
+        if (!table.size) {
+            return false;
+        }
+
+        for (size_t i = table.home(id);; i = (i + 1) & (table.size - 1)) {
+            Slot& slot = table.slots[i];
+            State state = slot.state.load(std::memory_order_relaxed);
+            if (state == State::Empty) {
+                return false;
+            }
+            if (state == State::Full && slot.id == id) {
+                if (slot.item.lock().get() != item) {
+                    return false;
+                }
+                slot.state.store(State::Deleted, std::memory_order_release);
+                table.count--;
+                break;
+            }
+        }
+
+        // Mostly tombstones: shrink back (failure just keeps the old table)
+        if (table.size > MIN_SLOTS && table.used - table.count > table.count * 2) {
+            rebuild(table.count);
+        }
+        return true;
+    }
+
+    // Make room for `entries` without another rebuild
+    bool reserve(size_t entries) {
+        const Table& current = tables.current();
+        if (slotsFor(entries) <= current.size) {
+            return true;
+        }
+        return rebuild(entries);
+    }
+
+    struct Stats {
+        size_t entries;
+        size_t slots;
+        size_t tombstones;    // Removed entries still taking up slots
+        size_t longestProbe;  // Worst-case slots visited by find() since the last rebuild
+        uint32_t rebuilds;
+    };
+    Stats getStats() const {
+        const Table& table = tables.current();
+        Stats stats;
+        stats.entries = table.count;
+        stats.slots = table.size;
+        stats.tombstones = table.used - table.count;
+        stats.longestProbe = table.longestProbe;
+        stats.rebuilds = rebuilds;
+        return stats;
+    }
+
+    IdTable() : rebuilds(0) {}
+    IdTable(const IdTable&) = delete;
+    IdTable& operator=(const IdTable&) = delete;
+
+private:
+    static constexpr size_t MIN_SLOTS = 16;
+
+    enum class State : uint8_t { Empty, Full, Deleted };
+
+    struct Slot {
+        std::atomic<State> state{State::Empty};
+        uint32_t id = 0;
+        std::weak_ptr<T> item;
+    };
+
+    struct Table {
+        std::unique_ptr<Slot[]> slots;
+        size_t capacity = 0;      // Slots allocated; the table uses `size` of them
+        size_t size = 0;          // Power of two, or 0 before the first insert
+        uint8_t shift = 32;
+        size_t used = 0;          // Full or deleted
+        size_t count = 0;         // Full
+        size_t longestProbe = 0;
+
+        Table() = default;
+        Table(const Table&) = delete;
+        Table& operator=(const Table&) = delete;
+
+        // Fibonacci hashing spreads djb2 IDs of similar names ("timer_12",
+        // "timer_13") that would otherwise share their low bits
+        size_t home(uint32_t id) const { return (id * 0x9E3779B1u) >> shift; }
+
+        // Empty table of `newSize` slots, reusing the allocation if it fits
+        bool resize(size_t newSize) {
+            if (newSize > capacity) {
+                Slot* fresh = new (std::nothrow) Slot[newSize];
+                if (!fresh) {
+                    return false;
+                }
+                slots.reset(fresh);
+                capacity = newSize;
+            }
+            size = newSize;
+            shift = 32;
+            for (size_t bits = newSize; bits > 1; bits >>= 1) {
+                shift--;
+            }
+            return true;
+        }
+
+        void clear() {
+            for (size_t i = 0; i < size; i++) {
+                slots[i].state.store(State::Empty, std::memory_order_relaxed);
+                slots[i].item.reset();
+            }
+            size = 0;
+            shift = 32;
+            used = count = longestProbe = 0;
+        }
+    };
+
+    static size_t slotsFor(size_t entries) {
+        size_t size = MIN_SLOTS;
+        while (size < entries * 3) {
+            size <<= 1;
+        }
+        return size;
+    }
+
+    // Copy the live entries into a table with room for `entries`
+    bool rebuild(size_t entries) {
+        const Table& current = tables.current();
+        Table* next = tables.fresh();
+        if (!next) {
+            return false;
+        }
+        if (!next->resize(slotsFor(entries))) {
+            tables.discard(next);
+            return false;
+        }
+
+        size_t mask = next->size - 1;
+        for (size_t from = 0; from < current.size; from++) {
+            const Slot& slot = current.slots[from];
+            if (slot.state.load(std::memory_order_relaxed) != State::Full) {
+                continue;
+            }
+            size_t i = next->home(slot.id);
+            size_t probe = 1;
+            while (next->slots[i].state.load(std::memory_order_relaxed) != State::Empty) {
+                i = (i + 1) & mask;
+                probe++;
+            }
+            next->slots[i].id = slot.id;
+            next->slots[i].item = slot.item;
+            next->slots[i].state.store(State::Full, std::memory_order_relaxed);
+            next->used++;
+            next->count++;
+            if (probe > next->longestProbe) {
+                next->longestProbe = probe;
+            }
+        }
+
+        tables.publish(next);
+        rebuilds++;
+        return true;
+    }
+
+    Snapshot<Table> tables;
+    uint32_t rebuilds;
+};
+
+} // namespace ESPLooper
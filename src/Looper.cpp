@@ -1,5 +1,6 @@
 #include "Looper.h"
 #include "AutoTask.h"
+#include "Coroutine.h"
 #include "OriginalAPI.h"
 #include <Arduino.h>
 #include <algorithm>
@@ -8,15 +9,15 @@
 namespace ESPLooper {
 
 Looper::Looper()
-    : eventDispatcherHandle(nullptr), initialized(false),
-      currentState(tState::Loop), currentEventData(nullptr),
-      currentTask(nullptr) {
+    : eventDispatcherHandles{}, initialized(false) {
   tasksMutex = xSemaphoreCreateMutex();
 }
 
 Looper::~Looper() {
-  if (eventDispatcherHandle) {
-    vTaskDelete(eventDispatcherHandle);
+  for (TaskHandle_t handle : eventDispatcherHandles) {
+    if (handle) {
+      vTaskDelete(handle);
+    }
   }
   if (tasksMutex) {
     vSemaphoreDelete(tasksMutex);
@@ -29,21 +30,130 @@ Looper &Looper::getInstance() {
 }
 
 void Looper::begin(UBaseType_t dispatcherPriority, BaseType_t dispatcherCore) {
+  LooperConfig cfg;
+  cfg.dispatcherPriority = dispatcherPriority;
+  cfg.dispatcherCore = dispatcherCore;
+  begin(cfg);
+}
+
+void Looper::begin(const LooperConfig &cfg) {
   if (initialized) {
     return;
   }
 
-  // Create event dispatcher task
-  if (dispatcherCore == tskNO_AFFINITY) {
-    xTaskCreate(eventDispatcherTask, "EventDispatcher", 4096, this,
-                dispatcherPriority, &eventDispatcherHandle);
+  config = cfg;
+  EventBus &eventBus = EventBus::getInstance();
+  eventBus.setDispatchMode(config.dispatchMode);
+  if (!eventBus.setTransport(config.eventTransport)) {
+    log_w("Event transport could not be switched (ring allocation failed or "
+          "events already queued); keeping the current one");
+  }
+  eventBus.setLaneScheduling(config.laneScheduling, config.laneWeights);
+
+  // A pool that cannot be allocated leaves its feature off; printStats
+  // reports it as failed
+  if (config.eventPoolSize > 0 &&
+      !eventBus.configurePool(config.eventPoolSize, config.payloadPoolSize,
+                              config.payloadBlockSize)) {
+    log_w("Event pool (%u events, %u payloads) could not be allocated",
+          (unsigned)config.eventPoolSize, (unsigned)config.payloadPoolSize);
+  }
+  if (config.isrEventSlots > 0 &&
+      !eventBus.configureISRSlots(config.isrEventSlots)) {
+    log_w("ISR event slots (%u) could not be allocated",
+          (unsigned)config.isrEventSlots);
+  }
+  if (config.bufferPoolSize > 0 &&
+      !eventBus.configureBuffers(config.bufferPoolSize, config.bufferSize)) {
+    log_w("Buffer pool (%u x %u bytes) could not be allocated",
+          (unsigned)config.bufferPoolSize, (unsigned)config.bufferSize);
+  }
+
+  for (const TaskStackClass &stacks : config.taskStacks) {
+    if (stacks.count > 0 &&
+        !TaskStacks::addClass(stacks.stackSize, stacks.count)) {
+      log_w("Task stack class (%u x %u bytes) could not be added",
+            (unsigned)stacks.count, (unsigned)stacks.stackSize);
+    }
+  }
+  TaskStacks::setStrict(config.staticTasksOnly);
+  TaskWorkers::configure(config.parkedWorkers);
+  RecycledBlocks::setLimit(config.recycledTasks);
+
+  // Create event dispatcher task(s); the parameter is the queue set index.
+  // Without a dispatcher nothing is delivered, so a failure here is an error
+  bool perCore = config.perCoreDispatch && eventBus.enablePerCoreDispatch();
+  if (config.perCoreDispatch && !perCore) {
+    log_w("Per-core dispatch could not be enabled; using one dispatcher");
+  }
+  if (perCore) {
+    for (size_t core = 0; core < EventBus::CORE_COUNT; core++) {
+      char name[20];
+      snprintf(name, sizeof(name), "EventDispatcher%u", (unsigned)core);
+      if (xTaskCreatePinnedToCore(eventDispatcherTask, name,
+                                  config.dispatcherStackSize, (void *)core,
+                                  config.dispatcherPriority,
+                                  &eventDispatcherHandles[core],
+                                  core) != pdPASS) {
+        log_e("Event dispatcher for core %u could not be created",
+              (unsigned)core);
+        eventDispatcherHandles[core] = nullptr;
+      }
+      eventBus.setDispatcher(eventDispatcherHandles[core], core);
+    }
   } else {
-    xTaskCreatePinnedToCore(eventDispatcherTask, "EventDispatcher", 4096, this,
-                            dispatcherPriority, &eventDispatcherHandle,
-                            dispatcherCore);
+    BaseType_t created;
+    if (config.dispatcherCore == tskNO_AFFINITY) {
+      created = xTaskCreate(eventDispatcherTask, "EventDispatcher",
+                            config.dispatcherStackSize, nullptr,
+                            config.dispatcherPriority,
+                            &eventDispatcherHandles[0]);
+    } else {
+      created = xTaskCreatePinnedToCore(
+          eventDispatcherTask, "EventDispatcher", config.dispatcherStackSize,
+          nullptr, config.dispatcherPriority, &eventDispatcherHandles[0],
+          config.dispatcherCore);
+    }
+    if (created != pdPASS) {
+      log_e("Event dispatcher could not be created");
+      eventDispatcherHandles[0] = nullptr;
+    }
+    eventBus.setDispatcher(eventDispatcherHandles[0]);
   }
 
-  // Initialize all auto-registered tasks
+  // Timers, threads and coroutines created later fall back to their own
+  // tasks (or fail to spawn) where a service is missing
+  if (config.timerMode == TimerMode::Wheel &&
+      !TimerService::createServices(config.timerServicePriority,
+                                    config.timerServiceStackSize)) {
+    log_e("Timer services could not be created");
+  }
+  if (config.threadMode == ThreadMode::Executor &&
+      !Executor::createWorkers(config.executorPriority,
+                               config.executorStackSize)) {
+    log_e("Executor workers could not be created");
+  }
+#if defined(__cpp_impl_coroutine)
+  if (config.coroutines) {
+    if (config.coroutineFrames > 0 &&
+        !CoFrameArena::configure(config.coroutineFrameSize,
+                                 config.coroutineFrames)) {
+      log_w("Coroutine frame pool (%u x %u bytes) could not be allocated",
+            (unsigned)config.coroutineFrames,
+            (unsigned)config.coroutineFrameSize);
+    }
+    if (!CoScheduler::createSchedulers(config.coroutinePriority,
+                                       config.coroutineStackSize)) {
+      log_e("Coroutine schedulers could not be created");
+    }
+  }
+#endif
+
+  // Initialize all auto-registered tasks, growing the task list once
+  if (xSemaphoreTake(tasksMutex, portMAX_DELAY)) {
+    tasks.reserve(tasks.size() + AutoTask::count());
+    xSemaphoreGive(tasksMutex);
+  }
   AutoTask::initAll();
 
   initialized = true;
@@ -54,10 +164,33 @@ void Looper::addTask(std::shared_ptr<Task> task) {
     return;
   }
 
+  // Tasks added directly are registered under their name
+  if (!task->taskIdString) {
+    task->taskIdString = task->getName();
+    task->taskId = EVENT_ID(task->taskIdString);
+  }
+
   if (xSemaphoreTake(tasksMutex, portMAX_DELAY)) {
     tasks.push_back(task);
     xSemaphoreGive(tasksMutex);
   }
+
+  switch (registry.insert(task->taskId, task)) {
+  case TaskRegistry::InsertResult::Duplicate:
+    log_w("Task \"%s\" replaces an earlier task with that name",
+          task->taskIdString);
+    break;
+  case TaskRegistry::InsertResult::Collision:
+    log_w("Task \"%s\" replaces a task with the same ID (0x%08x)",
+          task->taskIdString, task->taskId);
+    break;
+  case TaskRegistry::InsertResult::NoMemory:
+    log_e("Task \"%s\" can't be registered: out of memory",
+          task->taskIdString);
+    break;
+  default:
+    break;
+  }
 }
 
 void Looper::removeTask(std::shared_ptr<Task> task) {
@@ -67,16 +200,10 @@ void Looper::removeTask(std::shared_ptr<Task> task) {
 
   // Call Exit state before removing
   if (task->hasStates()) {
-    currentTask = task;
     task->executeWithState(tState::Exit);
-    currentTask = nullptr;
   }
 
-  // Remove from taskMap
-  if (xSemaphoreTake(tasksMutex, portMAX_DELAY)) {
-    taskMap.erase(task->getId());
-    xSemaphoreGive(tasksMutex);
-  }
+  registry.remove(task->getId(), task.get());
 
   if (xSemaphoreTake(tasksMutex, portMAX_DELAY)) {
     auto it = std::find(tasks.begin(), tasks.end(), task);
@@ -100,9 +227,14 @@ std::shared_ptr<TimerTask>
 Looper::addTimer(const char *name, Task::TaskCallback callback,
                  uint32_t periodMs, bool autoStart, BaseType_t coreId,
                  uint32_t stackSize, UBaseType_t priority) {
-  auto task = std::make_shared<TimerTask>(name, callback, periodMs, autoStart,
-                                          stackSize, priority, coreId);
+  auto task = std::allocate_shared<TimerTask>(
+      RecyclingAllocator<TimerTask>(), name, std::move(callback), periodMs,
+      autoStart, stackSize, priority, coreId);
+  addTimer(name, task);
+  return task;
+}
 
+void Looper::addTimer(const char *name, std::shared_ptr<TimerTask> task) {
   // Store ID for lookup
   uint32_t hashId = EVENT_ID(name);
   task->taskId = hashId;
@@ -112,29 +244,26 @@ Looper::addTimer(const char *name, Task::TaskCallback callback,
   task->enableEvents();
   task->enableStates();
 
-  // Add to map
-  if (xSemaphoreTake(tasksMutex, portMAX_DELAY)) {
-    taskMap[hashId] = task;
-    xSemaphoreGive(tasksMutex);
-  }
-
   addTask(task);
 
   // Call Setup state
-  currentTask = task;
   task->executeWithState(tState::Setup);
-  currentTask = nullptr;
-
-  return task;
 }
 
 std::shared_ptr<ListenerTask>
 Looper::addListener(const char *name, uint32_t eventId,
                     ListenerTask::EventCallback callback, BaseType_t coreId,
-                    uint32_t stackSize, UBaseType_t priority) {
-  auto task = std::make_shared<ListenerTask>(name, eventId, callback, stackSize,
-                                             priority, coreId);
+                    uint32_t stackSize, UBaseType_t priority,
+                    size_t mailboxDepth) {
+  auto task = std::allocate_shared<ListenerTask>(
+      RecyclingAllocator<ListenerTask>(), name, eventId, std::move(callback),
+      stackSize, priority, coreId, mailboxDepth);
+  addListener(name, task);
+  return task;
+}
 
+void Looper::addListener(const char *name,
+                         std::shared_ptr<ListenerTask> task) {
   // Store ID for lookup
   uint32_t hashId = EVENT_ID(name);
   task->taskId = hashId;
@@ -144,14 +273,7 @@ Looper::addListener(const char *name, uint32_t eventId,
   task->enableEvents();
   task->enableStates();
 
-  // Add to map
-  if (xSemaphoreTake(tasksMutex, portMAX_DELAY)) {
-    taskMap[hashId] = task;
-    xSemaphoreGive(tasksMutex);
-  }
-
   addTask(task);
-  return task;
 }
 
 void Looper::addTicker(const char *name, std::shared_ptr<TickerTask> task) {
@@ -164,18 +286,10 @@ void Looper::addTicker(const char *name, std::shared_ptr<TickerTask> task) {
   task->enableEvents();
   task->enableStates();
 
-  // Add to map
-  if (xSemaphoreTake(tasksMutex, portMAX_DELAY)) {
-    taskMap[hashId] = task;
-    xSemaphoreGive(tasksMutex);
-  }
-
   addTask(task);
 
   // Call Setup state
-  currentTask = task;
   task->executeWithState(tState::Setup);
-  currentTask = nullptr;
 }
 
 void Looper::addThread(const char *name, std::shared_ptr<ThreadTask> task) {
@@ -188,33 +302,60 @@ void Looper::addThread(const char *name, std::shared_ptr<ThreadTask> task) {
   task->enableEvents();
   task->enableStates();
 
-  // Add to map
-  if (xSemaphoreTake(tasksMutex, portMAX_DELAY)) {
-    taskMap[hashId] = task;
-    xSemaphoreGive(tasksMutex);
-  }
-
   addTask(task);
 
   // Call Setup state
-  currentTask = task;
   task->executeWithState(tState::Setup);
-  currentTask = nullptr;
+}
+
+void Looper::notifyThread(uint32_t id) {
+  auto task = getTask(id);
+  if (task && task->isThread()) {
+    static_cast<ThreadTask *>(task.get())->notify();
+  }
+}
+
+void Looper::notifyThreads() {
+  forEachTask([](Task &task) {
+    if (task.isThread()) {
+      static_cast<ThreadTask &>(task).signal();
+    }
+  });
 }
 
 bool Looper::sendEvent(uint32_t eventId, void *data, size_t dataSize,
-                       bool copyData) {
-  return EventBus::getInstance().send(eventId, data, dataSize, copyData);
+                       bool copyData, EventPriority priority) {
+  return EventBus::getInstance().send(eventId, data, dataSize, copyData,
+                                      priority);
 }
 
 bool Looper::sendEvent(const char *eventName, void *data, size_t dataSize,
-                       bool copyData) {
-  return sendEvent(EVENT_ID(eventName), data, dataSize, copyData);
+                       bool copyData, EventPriority priority) {
+  return sendEvent(EVENT_ID(eventName), data, dataSize, copyData, priority);
+}
+
+size_t Looper::sendBatch(const BatchEvent *events, size_t count,
+                         EventPriority priority) {
+  return EventBus::getInstance().sendBatch(events, count, priority);
+}
+
+bool IRAM_ATTR Looper::sendEventFromISR(uint32_t eventId, void *data,
+                                        size_t dataSize, bool copyData,
+                                        EventPriority priority) {
+  EventBus *eventBus = EventBus::isrInstance();
+  return eventBus &&
+         eventBus->sendFromISR(eventId, data, dataSize, copyData, priority);
 }
 
 std::shared_ptr<Task> Looper::getTask(const char *name) {
-  std::shared_ptr<Task> result;
+  std::shared_ptr<Task> result = registry.find(EVENT_ID(name));
+  if (!result || strcmp(result->getIdString(), name) == 0) {
+    return result;
+  }
 
+  // The ID belongs to another name: this task, if any, was replaced by
+  // a colliding one and is only in the list
+  result = nullptr;
   if (xSemaphoreTake(tasksMutex, portMAX_DELAY)) {
     for (auto &task : tasks) {
       if (strcmp(task->getName(), name) == 0) {
@@ -228,6 +369,15 @@ std::shared_ptr<Task> Looper::getTask(const char *name) {
   return result;
 }
 
+void Looper::forEachTask(FunctionRef<void(Task &)> visit) const {
+  if (xSemaphoreTake(tasksMutex, portMAX_DELAY)) {
+    for (const auto &task : tasks) {
+      visit(*task);
+    }
+    xSemaphoreGive(tasksMutex);
+  }
+}
+
 size_t Looper::getTaskCount() const {
   size_t count = 0;
   if (xSemaphoreTake(tasksMutex, portMAX_DELAY)) {
@@ -239,27 +389,161 @@ size_t Looper::getTaskCount() const {
 
 void Looper::printStats() const {
   Serial.println("=== ESP-Looper Statistics ===");
-  Serial.printf("Tasks: %d\n", getTaskCount());
+  Serial.printf("Tasks: %u\n", (unsigned)getTaskCount());
+  TaskRegistry::Stats registryStats = registry.getStats();
+  Serial.printf("Task Registry: %u/%u slots, longest probe %u, "
+                "%u rebuilds, %u collisions, %u duplicates\n",
+                (unsigned)registryStats.tasks, (unsigned)registryStats.slots,
+                (unsigned)registryStats.longestProbe, registryStats.rebuilds,
+                registryStats.collisions, registryStats.duplicates);
   Serial.printf("Queued Events: %d\n",
                 EventBus::getInstance().getQueuedEvents());
-  Serial.println("\nTasks:");
-
-  if (xSemaphoreTake(tasksMutex, portMAX_DELAY)) {
-    for (const auto &task : tasks) {
-      Serial.printf("  - %s [Core: %d, Stack: %d bytes free]\n",
-                    task->getName(), task->getCoreId(),
-                    task->getStackHighWaterMark());
+  EventBus::Stats eventStats = EventBus::getInstance().getStats();
+  Serial.printf("Dispatcher Wakeups: %u\n", eventStats.dispatcherWakeups);
+  if (eventStats.coalescedEvents > 0) {
+    Serial.printf("Coalesced Events: %u\n", eventStats.coalescedEvents);
+  }
+  if (EventBus::getInstance().isPerCoreDispatch()) {
+    for (size_t core = 0; core < EventBus::CORE_COUNT; core++) {
+      EventBus::CoreStats coreStats = EventBus::getInstance().getCoreStats(core);
+      Serial.printf("  Core %u: depth %u, dispatched %u, wakeups %u\n",
+                    (unsigned)core, (unsigned)coreStats.depth,
+                    coreStats.dispatched, coreStats.wakeups);
     }
-    xSemaphoreGive(tasksMutex);
+    Serial.printf("Cross-Core Hops: %u\n", eventStats.crossCoreHops);
+  }
+  static const char *laneNames[EventBus::LANE_COUNT] = {"High", "Normal",
+                                                        "Low"};
+  for (size_t lane = 0; lane < EventBus::LANE_COUNT; lane++) {
+    EventBus::LaneStats laneStats = EventBus::getInstance().getLaneStats(
+        static_cast<EventPriority>(lane));
+    Serial.printf("  Lane %-6s: depth %u, sent %u, dropped %u\n",
+                  laneNames[lane], (unsigned)laneStats.depth, laneStats.sent,
+                  laneStats.dropped);
+  }
+  if (eventStats.eventPoolCapacity > 0) {
+    Serial.printf("Event Pool: %u/%u used, %u exhausted\n",
+                  (unsigned)eventStats.eventPoolInUse,
+                  (unsigned)eventStats.eventPoolCapacity,
+                  eventStats.eventPoolExhausted);
+  } else if (config.eventPoolSize > 0) {
+    Serial.printf("Event Pool: allocation of %u events failed\n",
+                  (unsigned)config.eventPoolSize);
   }
+  if (eventStats.payloadPoolCapacity > 0) {
+    Serial.printf("Payload Pool: %u/%u used, %u exhausted\n",
+                  (unsigned)eventStats.payloadPoolInUse,
+                  (unsigned)eventStats.payloadPoolCapacity,
+                  eventStats.payloadPoolExhausted);
+  } else if (config.eventPoolSize > 0 && config.payloadPoolSize > 0) {
+    Serial.printf("Payload Pool: allocation of %u blocks failed\n",
+                  (unsigned)config.payloadPoolSize);
+  }
+  if (eventStats.isrSlotCapacity > 0) {
+    Serial.printf("ISR Slots: %u, %u dropped\n",
+                  (unsigned)eventStats.isrSlotCapacity, eventStats.isrDropped);
+  } else if (config.isrEventSlots > 0) {
+    Serial.printf("ISR Slots: allocation of %u slots failed\n",
+                  (unsigned)config.isrEventSlots);
+  }
+  if (eventStats.bufferPoolCapacity > 0) {
+    Serial.printf("Buffer Pool: %u/%u used, %u exhausted\n",
+                  (unsigned)eventStats.bufferPoolInUse,
+                  (unsigned)eventStats.bufferPoolCapacity,
+                  eventStats.bufferPoolExhausted);
+  } else if (config.bufferPoolSize > 0) {
+    Serial.printf("Buffer Pool: allocation of %u buffers failed\n",
+                  (unsigned)config.bufferPoolSize);
+  }
+  if (TaskStacks::isEnabled()) {
+    Serial.print("Task Stacks:");
+    for (size_t i = 0; i < TaskStacks::getClassCount(); i++) {
+      TaskStacks::ClassStats stackStats = TaskStacks::getClassStats(i);
+      Serial.printf(" %u B %u/%u used%s", stackStats.stackSize,
+                    (unsigned)stackStats.inUse, (unsigned)stackStats.capacity,
+                    i + 1 < TaskStacks::getClassCount() ? "," : "");
+    }
+    TaskStacks::Stats poolStats = TaskStacks::getStats();
+    Serial.printf("; %u static tasks, %u heap fallbacks, %u failed\n",
+                  poolStats.staticTasks, poolStats.heapFallbacks,
+                  poolStats.failed);
+  }
+  if (TaskWorkers::isEnabled()) {
+    TaskWorkers::Stats workerStats = TaskWorkers::getStats();
+    Serial.printf("Task Workers: %u parked, %u created, %u reused, "
+                  "%u deleted; recycled timers %u, listeners %u\n",
+                  (unsigned)workerStats.parked, workerStats.created,
+                  workerStats.reused, workerStats.deleted,
+                  (unsigned)RecyclingAllocator<TimerTask>::recycled(),
+                  (unsigned)RecyclingAllocator<ListenerTask>::recycled());
+  }
+  if (config.timerMode == TimerMode::Wheel) {
+    // Index CORE_COUNT is the unpinned service
+    for (size_t core = 0; core <= EventBus::CORE_COUNT; core++) {
+      bool pinned = core < EventBus::CORE_COUNT;
+      TimerService *service =
+          TimerService::forCore(pinned ? (BaseType_t)core : tskNO_AFFINITY);
+      if (!service) {
+        continue;
+      }
+      TimerService::Stats timerStats = service->getStats();
+      Serial.printf("Timer Service (core %d): %u timers, %u fired, "
+                    "%u wakeups, max late %u ticks\n",
+                    pinned ? (int)core : -1, (unsigned)timerStats.timers,
+                    timerStats.fired, timerStats.wakeups,
+                    timerStats.maxLateness);
+    }
+  }
+  if (config.threadMode == ThreadMode::Executor) {
+    for (size_t core = 0; core < EventBus::CORE_COUNT; core++) {
+      Executor *worker = Executor::forCore(core);
+      if (!worker) {
+        continue;
+      }
+      Executor::Stats execStats = worker->getStats();
+      Serial.printf("Executor (core %d): %u tasks, %u steps, %u passes, "
+                    "%u wakeups\n",
+                    (int)core, (unsigned)execStats.tasks, execStats.steps,
+                    execStats.passes, execStats.wakeups);
+    }
+  }
+#if defined(__cpp_impl_coroutine)
+  if (config.coroutines) {
+    for (size_t core = 0; core < EventBus::CORE_COUNT; core++) {
+      CoScheduler *scheduler = CoScheduler::forCore(core);
+      if (!scheduler) {
+        continue;
+      }
+      CoScheduler::Stats coStats = scheduler->getStats();
+      Serial.printf("Coroutines (core %u): %u alive, %u resumes, "
+                    "%u wakeups\n",
+                    (unsigned)core, (unsigned)coStats.coroutines,
+                    coStats.resumes, coStats.wakeups);
+    }
+    CoFrameArena::Stats frameStats = CoFrameArena::getStats();
+    Serial.printf("Coroutine frames: %u/%u used (%u bytes each), largest "
+                  "%u bytes, %u failed\n",
+                  (unsigned)frameStats.inUse, (unsigned)frameStats.capacity,
+                  (unsigned)frameStats.frameSize,
+                  (unsigned)frameStats.largestFrame, frameStats.failed);
+  }
+#endif
+  Serial.println("\nTasks:");
+
+  forEachTask([](Task &task) {
+    Serial.printf("  - %s [Core: %d, Stack: %d bytes free]\n",
+                  task.getName(), task.getCoreId(),
+                  task.getStackHighWaterMark());
+  });
 }
 
 void Looper::eventDispatcherTask(void *parameter) {
   EventBus &eventBus = EventBus::getInstance();
+  BaseType_t core = (BaseType_t)(intptr_t)parameter;
 
   while (true) {
-    eventBus.processEvents();
-    vTaskDelay(pdMS_TO_TICKS(1)); // 1ms delay
+    eventBus.processEvents(core);
+    eventBus.waitForEvents(core);
   }
 }
 
@@ -270,15 +554,7 @@ std::shared_ptr<Task> Looper::operator[](const char *id) {
 }
 
 std::shared_ptr<Task> Looper::getTask(uint32_t id) {
-  std::shared_ptr<Task> result;
-  if (xSemaphoreTake(tasksMutex, portMAX_DELAY)) {
-    auto it = taskMap.find(id);
-    if (it != taskMap.end()) {
-      result = it->second;
-    }
-    xSemaphoreGive(tasksMutex);
-  }
-  return result;
+  return registry.find(id);
 }
 
 std::shared_ptr<TimerTask> Looper::getTimer(const char *id) {
@@ -316,19 +592,8 @@ std::shared_ptr<ThreadTask> Looper::getThread(uint32_t id) {
 // ===== State Management Methods =====
 
 tState Looper::thisState() const {
-  // Find the task that is calling this function by checking the current FreeRTOS task handle
-  TaskHandle_t callingTaskHandle = xTaskGetCurrentTaskHandle();
-  
-  // Search for the task with this handle (without mutex to avoid deadlock)
-  // This is safe because tasks vector is only modified during add/remove which is rare
-  for (const auto& task : tasks) {
-    if (task && task->getHandle() == callingTaskHandle) {
-      return task->currentState;
-    }
-  }
-  
-  // Default to Loop if not found
-  return tState::Loop;
+  // Loop outside framework callbacks
+  return TaskContext::current().state;
 }
 
 bool Looper::thisSetup() const { return thisState() == tState::Setup; }
@@ -339,10 +604,11 @@ bool Looper::thisEvent() const { return thisState() == tState::Event; }
 
 bool Looper::thisExit() const { return thisState() == tState::Exit; }
 
-void *Looper::eventData() const { return currentEventData; }
+void *Looper::eventData() const { return TaskContext::current().eventData; }
 
 const char *Looper::thisTaskName() const {
-  return currentTask ? currentTask->getName() : nullptr;
+  Task *task = TaskContext::current().task;
+  return task ? task->getName() : nullptr;
 }
 
 void Looper::executeTaskWithEvent(std::shared_ptr<Task> task,
@@ -351,13 +617,21 @@ void Looper::executeTaskWithEvent(std::shared_ptr<Task> task,
     return;
   }
 
-  currentTask = task;
-  currentEventData = event.data;
+  // Threads waiting in LP_WAIT_EVENT take the event on their own task
+  if (task->isThread()) {
+    auto *thread = static_cast<ThreadTask *>(task.get());
+    if (thread->hasInbox()) {
+      thread->post(event);
+      return;
+    }
+  }
 
-  task->executeWithState(tState::Event);
+  task->executeWithState(tState::Event, event.data);
 
-  currentTask = nullptr;
-  currentEventData = nullptr;
+  // The event may be what a parked LP_WAIT is waiting for
+  if (task->isThread()) {
+    static_cast<ThreadTask *>(task.get())->signal();
+  }
 }
 
 } // namespace ESPLooper
\ No newline at end of file
@@ -1,7 +1,8 @@
 #pragma once
 #include "Event.h"
 #include "Task.h"
-#include <map>
+#include "TaskRegistry.h"
+#include "TaskStacks.h"
 #include <memory>
 #include <vector>
 
@@ -11,14 +12,104 @@ namespace ESPLooper {
 class TickerTask;
 class ThreadTask;
 
+// How TimerTasks are run
+enum class TimerMode {
+  Task, // One FreeRTOS task (and stack) per timer
+  Wheel // Callbacks multiplexed on a TimerService task per core
+};
+
+// How TickerTasks and ThreadTasks are run
+enum class ThreadMode {
+  Task,    // One FreeRTOS task (and stack) per ticker/thread
+  Executor // Stepped cooperatively on an Executor worker per core
+};
+
+// Framework configuration applied by Looper::begin()
+struct LooperConfig {
+  UBaseType_t dispatcherPriority = 3;
+  BaseType_t dispatcherCore = 1;
+  uint32_t dispatcherStackSize = 4096;
+  // One dispatcher per core (dispatcherCore is then ignored); listeners run
+  // on the dispatcher of their coreId, unpinned ones on the sender's core
+  bool perCoreDispatch = false;
+  DispatchMode dispatchMode = DispatchMode::Notify;
+  EventTransport eventTransport = EventTransport::Queue;
+  LaneScheduling laneScheduling = LaneScheduling::Strict;
+  uint8_t laneWeights[EventBus::LANE_COUNT] = {8, 4, 1}; // High, Normal, Low
+
+  // Timers created after begin(); Wheel trades per-timer stacks for one
+  // shared service task per core (plus one for unpinned timers)
+  TimerMode timerMode = TimerMode::Task;
+  UBaseType_t timerServicePriority = 2;
+  uint32_t timerServiceStackSize = 4096;
+
+  // Tickers and threads created after begin(); Executor runs them all on
+  // one worker per core, whose stack must fit the deepest callback
+  ThreadMode threadMode = ThreadMode::Task;
+  UBaseType_t executorPriority = 1;
+  uint32_t executorStackSize = 8192;
+
+  // A thread parked in LP_WAIT re-checks its condition this often as well
+  // as when notified, so conditions nobody signals (pins, plain variables)
+  // still get picked up. 0 = only when notified, for sketches that notify
+  // every change. Semaphore, channel and event waits are woken by their
+  // sender and never re-check.
+  uint32_t waitRecheckMs = 100;
+
+  // Inbox of a thread that uses LP_WAIT_EVENT; events beyond it are dropped
+  size_t threadInboxDepth = 8;
+
+  // C++20 coroutines (CoTask, see Coroutine.h): one scheduler task per core.
+  // Frames come from a pool of coroutineFrames blocks of coroutineFrameSize
+  // bytes, or the heap when coroutineFrames is 0
+  bool coroutines = false;
+  UBaseType_t coroutinePriority = 1;
+  uint32_t coroutineStackSize = 4096;
+  size_t coroutineFrameSize = 256;
+  size_t coroutineFrames = 0;
+
+  // Static task memory: stacks and TCBs of own-task timers, tickers,
+  // threads and mailbox listeners come from these size classes ({stackSize,
+  // count}, reserved once in internal RAM) instead of the heap. A task
+  // takes the smallest free block that fits; when none does it uses the
+  // heap, or fails to start with staticTasksOnly
+  TaskStackClass taskStacks[LP_TASK_STACK_CLASSES] = {};
+  bool staticTasksOnly = false;
+
+  // Recycling for dynamic add/remove: up to parkedWorkers FreeRTOS tasks of
+  // removed own-task timers, tickers, threads and mailbox listeners wait
+  // for the next task with the same stack size and core instead of being
+  // deleted, and up to recycledTasks blocks of removed addTimer() and
+  // addListener() tasks are kept per type for the next one
+  size_t parkedWorkers = 0;
+  size_t recycledTasks = 0;
+
+  // Event pool (0 = allocate every event on the heap)
+  size_t eventPoolSize = 0;
+  size_t payloadPoolSize = 0;
+  size_t payloadBlockSize = 64;
+
+  // Preallocated events reserved for sendFromISR (0 = ISR sends disabled)
+  size_t isrEventSlots = 8;
+
+  // Loaned buffers for zero-copy events (0 = disabled)
+  size_t bufferPoolSize = 0;
+  size_t bufferSize = 1024;
+};
+
 class Looper {
 public:
   static Looper &getInstance();
 
   // Initialize the framework
   void begin(UBaseType_t dispatcherPriority = 3, BaseType_t dispatcherCore = 1);
+  void begin(const LooperConfig &config);
+  const LooperConfig &getConfig() const { return config; }
 
-  // Add tasks
+  // Add tasks. A task is registered under EVENT_ID(name). If that ID is
+  // already taken, by the same name or a clashing one, a warning is logged
+  // and the new task replaces the old one: the displaced task keeps running
+  // but can no longer be looked up or sent events by ID
   void addTask(std::shared_ptr<Task> task);
   void removeTask(std::shared_ptr<Task> task);
   void removeTask(const char *name);
@@ -29,30 +120,56 @@ public:
            bool autoStart = true, BaseType_t coreId = tskNO_AFFINITY,
            uint32_t stackSize = 4096, UBaseType_t priority = 1);
 
-  // Create event listener
+  // Create event listener. With mailboxDepth > 0 it runs in its own task
+  // on coreId/priority; otherwise it runs on the event dispatcher.
   std::shared_ptr<ListenerTask>
   addListener(const char *name, uint32_t eventId,
               ListenerTask::EventCallback callback,
               BaseType_t coreId = tskNO_AFFINITY, uint32_t stackSize = 4096,
-              UBaseType_t priority = 1);
+              UBaseType_t priority = 1, size_t mailboxDepth = 0);
 
-  // Add ticker/thread with ID registration (for auto-registration)
+  // Register already constructed tasks under `name` (for auto-registration,
+  // which builds them in static storage)
+  void addTimer(const char *name, std::shared_ptr<TimerTask> task);
+  void addListener(const char *name, std::shared_ptr<ListenerTask> task);
   void addTicker(const char *name, std::shared_ptr<TickerTask> task);
   void addThread(const char *name, std::shared_ptr<ThreadTask> task);
 
+  // Wake one thread, or every thread, parked in LP_WAIT so it re-checks its
+  // condition
+  void notifyThread(uint32_t id);
+  void notifyThreads();
+
   // Event system access
   EventBus &events() { return EventBus::getInstance(); }
 
   // Send event
   bool sendEvent(uint32_t eventId, void *data = nullptr, size_t dataSize = 0,
-                 bool copyData = false);
+                 bool copyData = false,
+                 EventPriority priority = EventPriority::Normal);
   bool sendEvent(const char *eventName, void *data = nullptr,
-                 size_t dataSize = 0, bool copyData = false);
+                 size_t dataSize = 0, bool copyData = false,
+                 EventPriority priority = EventPriority::Normal);
+
+  // Send a burst of events with one queue operation; returns how many
+  // were queued
+  size_t sendBatch(const BatchEvent *events, size_t count,
+                   EventPriority priority = EventPriority::Normal);
+
+  // Send event from an interrupt handler (no allocation, never blocks).
+  // Static so ISRs don't go through getInstance()
+  static bool sendEventFromISR(uint32_t eventId, void *data = nullptr,
+                               size_t dataSize = 0, bool copyData = true,
+                               EventPriority priority = EventPriority::Normal);
 
   // Task management
   std::shared_ptr<Task> getTask(const char *name);
   size_t getTaskCount() const;
 
+  // Call `visit` for every task, holding the task list lock: it must not
+  // add or remove tasks
+  void forEachTask(FunctionRef<void(Task &)> visit) const;
+
   // Task lookup by ID (Original Looper API)
   std::shared_ptr<Task> operator[](const char *id);
   std::shared_ptr<Task> getTask(uint32_t id);
@@ -69,7 +186,8 @@ public:
   std::shared_ptr<ThreadTask> getThread(const char *id);
   std::shared_ptr<ThreadTask> getThread(uint32_t id);
 
-  // Current task state info (Original Looper API)
+  // Current task state info (Original Looper API). Read from the caller's
+  // TaskContext: O(1), and safe from any task or core
   tState thisState() const;
   bool thisSetup() const;
   bool thisLoop() const;
@@ -85,22 +203,19 @@ public:
   // Statistics
   void printStats() const;
 
-  // Current execution context (public for Task access)
-  tState currentState;
-  void *currentEventData;
-  std::shared_ptr<Task> currentTask;
-
 private:
   Looper();
   ~Looper();
 
   std::vector<std::shared_ptr<Task>> tasks;
   SemaphoreHandle_t tasksMutex;
-  TaskHandle_t eventDispatcherHandle;
+  TaskHandle_t eventDispatcherHandles[EventBus::CORE_COUNT];
   bool initialized;
+  LooperConfig config;
 
-  // Map for fast ID lookup
-  std::map<uint32_t, std::shared_ptr<Task>> taskMap;
+  // Lock-free lookup by ID for getTask() and event routing (mutable: reads
+  // go through its reader gate)
+  mutable TaskRegistry registry;
 
   friend class Task;
 
@@ -124,6 +239,12 @@ private:
 #define ESP_SEND_EVENT_REF(eventId, data, size)                                \
   ESP_LOOPER.sendEvent(eventId, data, size, false)
 
+#define ESP_SEND_EVENT_PRIORITY(eventId, data, size, priority)                 \
+  ESP_LOOPER.sendEvent(eventId, data, size, true, priority)
+
+#define ESP_SEND_EVENT_ISR(eventId, data, size)                                \
+  ESPLooper::Looper::sendEventFromISR(eventId, data, size, true)
+
 // ========== Auto-registration macros (like original Looper) ==========
 
 // Helper macros for stringification
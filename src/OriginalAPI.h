@@ -4,8 +4,12 @@
 // Provides full compatibility with original Looper macros but using FreeRTOS
 
 #include "AutoTask.h"
+#include "Channel.h"
+#include "Executor.h"
 #include "Looper.h"
 #include <Arduino.h>
+#include <algorithm>
+#include <atomic>
 #include <freertos/semphr.h>
 
 // Helper macros for stringification and concatenation
@@ -14,91 +18,418 @@
 #define _LP_CONCAT_IMPL(a, b) a##b
 #define _LP_CONCAT(a, b) _LP_CONCAT_IMPL(a, b)
 
+// Threads that can be parked in LP_SEM_WAIT at once, over all semaphores;
+// beyond that LP_SEM_WAIT falls back to re-trying every tick
+#ifndef LP_SEM_WAITERS
+#define LP_SEM_WAITERS 8
+#endif
+
 namespace ESPLooper {
 
-// ===== Ticker Task - Continuously running task =====
-class TickerTask : public Task {
+// Threads parked in LP_SEM_WAIT, keyed by semaphore, so LP_SEM_SIGNAL wakes
+// only the threads waiting for the semaphore it gave. Like ChannelWaitList,
+// wakes are one-shot: a woken thread re-registers if its take fails again.
+class SemaphoreWaiters {
 public:
-  TickerTask(const char *name, TaskCallback callback, uint32_t stackSize = 4096,
-             UBaseType_t priority = 1, BaseType_t coreId = tskNO_AFFINITY)
-      : Task(name, callback, stackSize, priority, coreId) {
-    enableStates(); // Enable state machine by default
-    start();
+  static bool add(SemaphoreHandle_t sem, const ChannelWaiter &waiter) {
+    bool added = false;
+    portENTER_CRITICAL(&lock);
+    size_t n = count.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < n; i++) {
+      if (slots[i].waiter.ctx == waiter.ctx) {
+        slots[i].sem = sem;
+        added = true;
+        break;
+      }
+    }
+    if (!added && n < LP_SEM_WAITERS) {
+      slots[n] = {sem, waiter};
+      count.store(n + 1, std::memory_order_relaxed);
+      added = true;
+    }
+    portEXIT_CRITICAL(&lock);
+
+    // Pairs with the fence in wake(): either the caller's retry sees the
+    // give or the signaller sees the caller registered
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return added;
   }
 
-  bool isTicker() const override { return true; }
+  static void remove(void *ctx) {
+    if (count.load(std::memory_order_relaxed) == 0) {
+      return;
+    }
+    portENTER_CRITICAL(&lock);
+    size_t n = count.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < n; i++) {
+      if (slots[i].waiter.ctx == ctx) {
+        slots[i] = slots[n - 1];
+        count.store(n - 1, std::memory_order_relaxed);
+        break;
+      }
+    }
+    portEXIT_CRITICAL(&lock);
+  }
+
+  static void wake(SemaphoreHandle_t sem) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (count.load(std::memory_order_relaxed) == 0) {
+      return;
+    }
+
+    // Wake outside the lock - waking may notify a task
+    ChannelWaiter woken[LP_SEM_WAITERS];
+    size_t wokenCount = 0;
+    portENTER_CRITICAL(&lock);
+    size_t n = count.load(std::memory_order_relaxed);
+    for (size_t i = n; i-- > 0;) {
+      if (slots[i].sem == sem) {
+        woken[wokenCount++] = slots[i].waiter;
+        slots[i] = slots[--n];
+      }
+    }
+    count.store(n, std::memory_order_relaxed);
+    portEXIT_CRITICAL(&lock);
+
+    for (size_t i = 0; i < wokenCount; i++) {
+      woken[i].wake(woken[i].ctx);
+    }
+  }
+
+private:
+  struct Slot {
+    SemaphoreHandle_t sem;
+    ChannelWaiter waiter;
+  };
+
+  static inline portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+  static inline std::atomic<size_t> count{0};
+  static inline Slot slots[LP_SEM_WAITERS];
+};
+
+// ===== Cooperative Task - Base of tickers and threads =====
+// Runs in its own FreeRTOS task by default. With ThreadMode::Executor it has
+// no task of its own: step() is called from the Executor worker of its core
+// and stackSize/priority are not used.
+class CoopTask : public Task {
+public:
+  CoopTask(const char *name, TaskCallback callback, uint32_t stackSize,
+           UBaseType_t priority, BaseType_t coreId)
+      : Task(name, callback, stackSize, priority, coreId), executor(nullptr),
+        wakeups(0) {}
+
+  ~CoopTask() override {
+    // Task::~Task can't reach the override
+    stop();
+  }
+
+  bool start() override {
+    // Workers only exist in ThreadMode::Executor (created by Looper::begin)
+    if (!executor) {
+      executor = Executor::forCore(coreId);
+    }
+    if (!executor) {
+      return Task::start();
+    }
+
+    if (state == TaskState::Running) {
+      return false;
+    }
+    shouldRun = true;
+    state = TaskState::Running;
+    executor->attach(this);
+    return true;
+  }
+
+  bool stop() override {
+    if (!executor) {
+      return Task::stop();
+    }
+
+    if (state == TaskState::Stopped) {
+      return false;
+    }
+    shouldRun = false;
+    state = TaskState::Stopped;
+    executor->detach(this);
+    return true;
+  }
+
+  bool pause() override {
+    if (!executor) {
+      return Task::pause();
+    }
+
+    if (state != TaskState::Running) {
+      return false;
+    }
+    state = TaskState::Paused;
+    executor->detach(this);
+    return true;
+  }
+
+  bool resume() override {
+    if (!executor) {
+      return Task::resume();
+    }
+
+    if (state != TaskState::Paused) {
+      return false;
+    }
+    state = TaskState::Running;
+    executor->attach(this);
+    return true;
+  }
+
+  // True when stepped by an Executor worker rather than its own task
+  bool onExecutor() const { return executor != nullptr; }
+
+  // Step again as soon as possible, cutting any sleep short
+  void notify() {
+    if (executor) {
+      executor->wake(this);
+    } else if (taskHandle) {
+      xTaskNotifyGive(taskHandle);
+    }
+  }
+
+  // Times the body has been stepped
+  uint32_t getWakeups() const { return wakeups; }
 
 protected:
-  void run() override {
+  // Ticks to sleep after a step unless notified; portMAX_DELAY = until
+  // notified. Tickers run every tick.
+  virtual TickType_t sleepTicks() const { return 1; }
+
+  // One iteration of the loop: Setup the first time, then Loop
+  void step() {
+    wakeups = wakeups + 1;
+
     // Call Setup state once at start
     if (statesEnabled && enabled && !setupCalled) {
       setupCalled = true;
       executeWithState(tState::Setup);
     }
 
-    while (shouldRun) {
-      if (enabled) {
-        if (statesEnabled) {
-          executeWithState(tState::Loop);
-        } else if (callback) {
-          callback();
-        }
-      }
-      // Small delay to prevent watchdog timeout and reduce CPU usage
-      vTaskDelay(pdMS_TO_TICKS(
-          1)); // 1ms delay, allows other tasks and resets watchdog
+    if (enabled) {
+      executeWithState(tState::Loop);
     }
+  }
 
-    // Call Exit state once before task ends
-    if (statesEnabled) {
-      executeWithState(tState::Exit);
+  void run() override {
+    while (shouldRun) {
+      step();
+      // Sleep until the body's next deadline or a notify(); never less
+      // than a tick, which also keeps the watchdog fed
+      ulTaskNotifyTake(pdTRUE, sleepTicks());
     }
+    // Exit already ran in Looper::removeTask()
+  }
+
+  Executor *executor;
+  ExecNode execNode;
+  volatile uint32_t wakeups;
+
+  friend class Executor;
+};
+
+// ===== Ticker Task - Continuously running task =====
+class TickerTask : public CoopTask {
+public:
+  TickerTask(const char *name, TaskCallback callback, uint32_t stackSize = 4096,
+             UBaseType_t priority = 1, BaseType_t coreId = tskNO_AFFINITY)
+      : CoopTask(name, callback, stackSize, priority, coreId) {
+    enableStates(); // Enable state machine by default
+    start();
   }
+
+  bool isTicker() const override { return true; }
 };
 
 // ===== Thread Task with State Machine (Duff's Device) =====
-class ThreadTask : public Task {
+// The body returns at every LP_WAIT/LP_DELAY and resumes from _case on the
+// next step, so it needs no stack of its own between steps. The macros
+// record why it returned: a delay sleeps until its deadline and a failed
+// LP_WAIT parks until the thread is notified.
+//
+// The first LP_WAIT_EVENT gives the thread a bounded inbox. From then on
+// events sent to its ID are queued there and wake the thread instead of
+// running the body in tState::Event on the dispatcher.
+class ThreadTask : public CoopTask {
 public:
+  // Why the body last returned
+  enum class WaitKind : uint8_t {
+    None,   // Finished or yielded: run again next tick
+    Delay,  // LP_DELAY: sleep until _delayUntil
+    Signal, // LP_WAIT: park until notified or the re-check interval
+    Parked, // Semaphore, channel or inbox: park until its waker notifies
+    Poll    // LP_WAIT_POLL: re-check at _delayUntil or when notified
+  };
+
   ThreadTask(const char *name, TaskCallback callback, uint32_t stackSize = 8192,
              UBaseType_t priority = 1, BaseType_t coreId = tskNO_AFFINITY)
-      : Task(name, callback, stackSize, priority, coreId), _case(0),
-        _delayUntil(0), _eventFlag(false) {
+      : CoopTask(name, callback, stackSize, priority, coreId), _case(0),
+        _delayUntil(0), _wait(WaitKind::None), _event(nullptr),
+        _parkedOn(nullptr), inbox(nullptr), droppedEvents(0) {
     enableStates(); // Enable state machine by default
     start();
   }
 
+  ~ThreadTask() override {
+    // The body must not be mid-step while the inbox goes away
+    stop();
+
+    // Nor may a channel or semaphore wake us afterwards
+    if (_parkedOn) {
+      _parkedOn->cancel(this);
+    }
+    SemaphoreWaiters::remove(this);
+
+    EventBus &bus = EventBus::getInstance();
+    if (_event) {
+      bus.releaseEvent(_event);
+    }
+    if (inbox) {
+      Event *pending;
+      while (xQueueReceive(inbox, &pending, 0) == pdTRUE) {
+        bus.releaseEvent(pending);
+      }
+      vQueueDelete(inbox);
+    }
+  }
+
   bool isThread() const override { return true; }
 
+  // Wake the thread if it may be waiting on a condition. Threads sleeping
+  // in LP_DELAY are left alone.
+  void signal() {
+    if (_wait != WaitKind::Delay) {
+      notify();
+    }
+  }
+
+  // Queue an event for LP_WAIT_EVENT (called by the dispatcher). Never
+  // blocks: when the inbox is full the event is dropped and counted.
+  void post(const Event &evt) {
+    EventBus &bus = EventBus::getInstance();
+    Event *held = bus.retainEvent(evt);
+    if (xQueueSend(inbox, &held, 0) != pdTRUE) {
+      bus.releaseEvent(held);
+      droppedEvents = droppedEvents + 1;
+    }
+    notify();
+  }
+
+  bool hasInbox() const { return inbox != nullptr; }
+  size_t getPendingEvents() const {
+    return inbox ? uxQueueMessagesWaiting(inbox) : 0;
+  }
+  uint32_t getDroppedEvents() const { return droppedEvents; }
+
   // Thread state for Duff's Device pattern
   uint16_t _case;
   TickType_t _delayUntil;
-  bool _eventFlag;
+  volatile WaitKind _wait;
+  Event *_event; // Taken by the last LP_WAIT_EVENT; valid until the next
+  ChannelBase *_parkedOn; // Channel of a pending LP_CHANNEL_SEND/RECV
 
-protected:
-  void run() override {
-    // Call Setup state once at start
-    if (statesEnabled && enabled && !setupCalled) {
-      setupCalled = true;
-      executeWithState(tState::Setup);
-    }
+  // Wraparound-safe: true once the tick count has passed _delayUntil
+  bool _deadlinePassed() const {
+    return static_cast<int32_t>(xTaskGetTickCount() - _delayUntil) >= 0;
+  }
 
-    while (shouldRun) {
-      if (enabled) {
-        if (statesEnabled) {
-          executeWithState(tState::Loop);
-        } else if (callback) {
-          callback();
-        }
+  // LP_WAIT_EVENT: swap the held event for the next one in the inbox
+  bool _takeEvent() {
+    if (!inbox) {
+      size_t depth = Looper::getInstance().getConfig().threadInboxDepth;
+      inbox = xQueueCreate(depth > 0 ? depth : 1, sizeof(Event *));
+      if (!inbox) {
+        return false;
       }
-      // Small delay to prevent watchdog timeout
-      vTaskDelay(pdMS_TO_TICKS(1));
     }
 
-    // Call Exit state once before task ends
-    if (statesEnabled) {
-      executeWithState(tState::Exit);
+    Event *next;
+    if (xQueueReceive(inbox, &next, 0) != pdTRUE) {
+      return false;
+    }
+    if (_event) {
+      EventBus::getInstance().releaseEvent(_event);
+    }
+    _event = next;
+    return true;
+  }
+
+  // LP_CHANNEL_SEND/RECV: how the channel wakes this thread
+  ChannelWaiter _waiter() {
+    return {[](void *ctx) { static_cast<ThreadTask *>(ctx)->notify(); },
+            this};
+  }
+
+  // LP_SEM_WAIT: take `sem`, or park until LP_SEM_SIGNAL gives it. True to
+  // continue, false to return and wait.
+  bool _semTake(SemaphoreHandle_t sem) {
+    if (xSemaphoreTake(sem, 0) == pdTRUE) {
+      SemaphoreWaiters::remove(this);
+      return true;
+    }
+    if (!SemaphoreWaiters::add(sem, _waiter())) {
+      // Too many waiters to be woken: try again next tick
+      _delayUntil = xTaskGetTickCount() + 1;
+      _wait = WaitKind::Poll;
+      return false;
+    }
+    // A give between the first take and registering would wake nobody
+    if (xSemaphoreTake(sem, 0) == pdTRUE) {
+      SemaphoreWaiters::remove(this);
+      return true;
+    }
+    _wait = WaitKind::Parked;
+    return false;
+  }
+
+  // LP_CHANNEL_SEND/RECV: true to continue, false to return and wait
+  bool _channelDone(ChannelStatus status, ChannelBase &channel) {
+    switch (status) {
+    case ChannelStatus::Done:
+      _parkedOn = nullptr;
+      return true;
+    case ChannelStatus::Waiting:
+      _parkedOn = &channel;
+      _wait = WaitKind::Parked;
+      return false;
+    default:
+      // Too many waiters to be woken: try again next tick
+      _parkedOn = nullptr;
+      _delayUntil = xTaskGetTickCount() + 1;
+      _wait = WaitKind::Poll;
+      return false;
+    }
+  }
+
+protected:
+  TickType_t sleepTicks() const override {
+    switch (_wait) {
+    case WaitKind::Delay:
+    case WaitKind::Poll: {
+      int32_t remaining =
+          static_cast<int32_t>(_delayUntil - xTaskGetTickCount());
+      return remaining > 0 ? remaining : 1;
+    }
+    case WaitKind::Signal: {
+      // Re-check for conditions nobody signals, unless configured off
+      uint32_t recheckMs = Looper::getInstance().getConfig().waitRecheckMs;
+      return recheckMs ? std::max<TickType_t>(pdMS_TO_TICKS(recheckMs), 1)
+                       : portMAX_DELAY;
+    }
+    case WaitKind::Parked:
+      return portMAX_DELAY;
+    default:
+      return 1;
     }
   }
+
+  QueueHandle_t volatile inbox;
+  volatile uint32_t droppedEvents;
 };
 
 // ===== Auto Ticker - Auto-registered ticker task =====
@@ -111,17 +442,17 @@ public:
         priority(priority), coreId(coreId) {}
 
   void init() override {
-    auto task = std::make_shared<TickerTask>(name, callback, stackSize,
-                                             priority, coreId);
-    ESPLooper::Looper::getInstance().addTicker(name, task);
+    ESPLooper::Looper::getInstance().addTicker(
+        name, slot.make(name, callback, stackSize, priority, coreId));
   }
 
 private:
-  const char *name;
-  Task::TaskCallback callback;
-  uint32_t stackSize;
-  UBaseType_t priority;
-  BaseType_t coreId;
+  const char *const name;
+  const Task::TaskCallback callback;
+  const uint32_t stackSize;
+  const UBaseType_t priority;
+  const BaseType_t coreId;
+  TaskSlot<TickerTask> slot;
 };
 
 // ===== Auto Thread - Auto-registered thread task =====
@@ -134,8 +465,7 @@ public:
         priority(priority), coreId(coreId) {}
 
   void init() override {
-    auto task = std::make_shared<ThreadTask>(name, callback, stackSize,
-                                             priority, coreId);
+    auto task = slot.make(name, callback, stackSize, priority, coreId);
     ESPLooper::Looper::getInstance().addThread(name, task);
     threadHandle = task; // Store handle for access
   }
@@ -145,11 +475,12 @@ public:
   std::shared_ptr<ThreadTask> threadHandle;
 
 private:
-  const char *name;
-  Task::TaskCallback callback;
-  uint32_t stackSize;
-  UBaseType_t priority;
-  BaseType_t coreId;
+  const char *const name;
+  const Task::TaskCallback callback;
+  const uint32_t stackSize;
+  const UBaseType_t priority;
+  const BaseType_t coreId;
+  TaskSlot<ThreadTask> slot;
 };
 
 } // namespace ESPLooper
@@ -181,6 +512,7 @@ private:
 
 // Thread state machine control macros
 #define LP_THREAD_BEGIN()                                                      \
+  _LP_THREAD_HANDLE->_wait = ESPLooper::ThreadTask::WaitKind::None;            \
   switch (_LP_THREAD_HANDLE->_case) {                                          \
   case 0:;
 
@@ -202,27 +534,86 @@ private:
   case __LINE__:;                                                              \
   } while (0)
 
+// Parks the thread until it is notified (an event sent to its ID,
+// LP_NOTIFY) and re-checks the condition then, and every
+// LooperConfig::waitRecheckMs (100 ms by default, 0 = only when notified)
 #define LP_WAIT(cond)                                                          \
   do {                                                                         \
     _LP_THREAD_HANDLE->_case = __LINE__;                                       \
   case __LINE__:                                                               \
-    if (!(cond))                                                               \
+    if (!(cond)) {                                                             \
+      _LP_THREAD_HANDLE->_wait = ESPLooper::ThreadTask::WaitKind::Signal;      \
+      return;                                                                  \
+    }                                                                          \
+  } while (0)
+
+// For conditions nobody signals (pins, Serial.available()): also re-checks
+// every `ms`
+#define LP_WAIT_POLL(cond, ms)                                                 \
+  do {                                                                         \
+    _LP_THREAD_HANDLE->_case = __LINE__;                                       \
+  case __LINE__:                                                               \
+    if (!(cond)) {                                                             \
+      _LP_THREAD_HANDLE->_delayUntil = xTaskGetTickCount() + pdMS_TO_TICKS(ms);\
+      _LP_THREAD_HANDLE->_wait = ESPLooper::ThreadTask::WaitKind::Poll;        \
       return;                                                                  \
+    }                                                                          \
   } while (0)
 
+// Sleeps until the deadline instead of re-checking every tick
 #define LP_DELAY(ms)                                                           \
   do {                                                                         \
     _LP_THREAD_HANDLE->_delayUntil = xTaskGetTickCount() + pdMS_TO_TICKS(ms);  \
-    LP_WAIT(xTaskGetTickCount() >= _LP_THREAD_HANDLE->_delayUntil);            \
+    _LP_THREAD_HANDLE->_case = __LINE__;                                       \
+  case __LINE__:                                                               \
+    if (!_LP_THREAD_HANDLE->_deadlinePassed()) {                               \
+      _LP_THREAD_HANDLE->_wait = ESPLooper::ThreadTask::WaitKind::Delay;       \
+      return;                                                                  \
+    }                                                                          \
   } while (0)
 
+// Wake a thread parked in LP_WAIT so it re-checks its condition
+#define LP_NOTIFY(id) ESP_LOOPER.notifyThread(EVENT_ID(id))
+
+// Parks the thread until an event sent to its ID arrives in its inbox.
+// LP_EVENT() is that event until the next LP_WAIT_EVENT.
 #define LP_WAIT_EVENT()                                                        \
   do {                                                                         \
     _LP_THREAD_HANDLE->_case = __LINE__;                                       \
   case __LINE__:                                                               \
-    if (!_LP_THREAD_HANDLE->_eventFlag)                                        \
+    if (!_LP_THREAD_HANDLE->_takeEvent()) {                                    \
+      _LP_THREAD_HANDLE->_wait = ESPLooper::ThreadTask::WaitKind::Parked;      \
+      return;                                                                  \
+    }                                                                          \
+  } while (0)
+
+#define LP_EVENT() (*_LP_THREAD_HANDLE->_event)
+#define LP_EVENT_DATA() (_LP_THREAD_HANDLE->_event->data)
+
+// ===== CHANNELS - Typed bounded queues between threads =====
+// LP_CHANNEL(int, 8) jobs;  (statically sized, no heap; N a power of two)
+#define LP_CHANNEL(T, N) ESPLooper::Channel<T, N>
+#define LP_SPSC_CHANNEL(T, N) ESPLooper::SpscChannel<T, N>
+
+// Park the thread until `value` fits in the channel. `value` is evaluated
+// again on every attempt, so pass something that survives the wait.
+#define LP_CHANNEL_SEND(ch, value)                                             \
+  do {                                                                         \
+    _LP_THREAD_HANDLE->_case = __LINE__;                                       \
+  case __LINE__:                                                               \
+    if (!_LP_THREAD_HANDLE->_channelDone(                                      \
+            (ch).send((value), _LP_THREAD_HANDLE->_waiter()), (ch)))           \
+      return;                                                                  \
+  } while (0)
+
+// Park the thread until an element can be received into `var`
+#define LP_CHANNEL_RECV(ch, var)                                               \
+  do {                                                                         \
+    _LP_THREAD_HANDLE->_case = __LINE__;                                       \
+  case __LINE__:                                                               \
+    if (!_LP_THREAD_HANDLE->_channelDone(                                      \
+            (ch).recv((var), _LP_THREAD_HANDLE->_waiter()), (ch)))             \
       return;                                                                  \
-    _LP_THREAD_HANDLE->_eventFlag = false;                                     \
   } while (0)
 
 // Helper macro for thread body
@@ -250,6 +641,9 @@ private:
               _LP_CONCAT(_lp_thread_wrapper_, __LINE__)::handle =              \
                   _lp_thread_handle;                                           \
             }                                                                  \
+            /* Started before addThread() registered it: try next tick */      \
+            if (!_lp_thread_handle)                                            \
+              return;                                                          \
             auto _LP_THREAD_HANDLE = _lp_thread_handle;                        \
             _LP_THREAD_INNER(body)                                             \
           },                                                                   \
@@ -277,6 +671,9 @@ private:
               _LP_CONCAT(_lp_thread_wrapper_named_, __LINE__)::handle =        \
                   _lp_thread_handle;                                           \
             }                                                                  \
+            /* Started before addThread() registered it: try next tick */      \
+            if (!_lp_thread_handle)                                            \
+              return;                                                          \
             auto _LP_THREAD_HANDLE = _lp_thread_handle;                        \
             _LP_THREAD_INNER(body)                                             \
           },                                                                   \
@@ -328,11 +725,35 @@ inline size_t safe_sizeof(std::nullptr_t) { return 0; }
   ESP_LOOPER.sendEvent(EVENT_ID(id), static_cast<void *>(data),                \
                        _lp_event_helpers::safe_sizeof(data), true)
 
+// From an interrupt handler: copies *data inline (must fit in
+// Event::INLINE_SIZE), never allocates or blocks
+#define LP_SEND_EVENT_ISR(id, data)                                            \
+  do {                                                                         \
+    constexpr uint32_t _lp_isr_id = EVENT_ID(id);                              \
+    ESPLooper::Looper::sendEventFromISR(                                       \
+        _lp_isr_id, static_cast<void *>(data),                                 \
+        _lp_event_helpers::safe_sizeof(data), true);                           \
+  } while (0)
+
 #define LP_BROADCAST EVENT_ID("")
 
 // ===== SEMAPHORES - Using FreeRTOS semaphores =====
 typedef SemaphoreHandle_t LP_SEM;
 
 #define LP_SEM_CREATE() xSemaphoreCreateBinary()
-#define LP_SEM_SIGNAL(sem) xSemaphoreGive(sem)
-#define LP_SEM_WAIT(sem) LP_WAIT(xSemaphoreTake(sem, 0) == pdTRUE)
+// Gives the semaphore and wakes only the threads parked on it
+#define LP_SEM_SIGNAL(sem)                                                     \
+  do {                                                                         \
+    xSemaphoreGive(sem);                                                       \
+    ESPLooper::SemaphoreWaiters::wake(sem);                                    \
+  } while (0)
+
+// Parks the thread until LP_SEM_SIGNAL gives the semaphore, then takes it.
+// A semaphore given some other way is picked up by the LP_WAIT re-check.
+#define LP_SEM_WAIT(sem)                                                       \
+  do {                                                                         \
+    _LP_THREAD_HANDLE->_case = __LINE__;                                       \
+  case __LINE__:                                                               \
+    if (!_LP_THREAD_HANDLE->_semTake(sem))                                     \
+      return;                                                                  \
+  } while (0)
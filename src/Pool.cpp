@@ -0,0 +1,167 @@
+#include "Pool.h"
+#include <esp_attr.h>
+#include <new>
+#include <stdlib.h>
+
+namespace ESPLooper {
+
+BlockPool::BlockPool()
+    : blocks(nullptr), ownsBlocks(false), nextFree(nullptr), blockSize(0), capacity(0),
+      freeHead(EMPTY), inUse(0) {}
+
+BlockPool::~BlockPool() {
+  if (ownsBlocks) {
+    free(blocks);
+  }
+  delete[] nextFree;
+}
+
+bool BlockPool::begin(size_t size, size_t count, void *storage) {
+  if (blocks || size == 0 || count == 0 || count > MAX_BLOCKS) {
+    return false;
+  }
+
+  size = alignBlock(size);
+
+  ownsBlocks = storage == nullptr;
+  blocks = static_cast<uint8_t *>(ownsBlocks ? malloc(size * count) : storage);
+  nextFree = new (std::nothrow) std::atomic<uint16_t>[count];
+  if (!blocks || !nextFree) {
+    if (ownsBlocks) {
+      free(blocks);
+    }
+    delete[] nextFree;
+    blocks = nullptr;
+    nextFree = nullptr;
+    return false;
+  }
+
+  blockSize = size;
+  capacity = count;
+
+  for (size_t i = 0; i < count; i++) {
+    nextFree[i].store(i + 1 < count ? i + 1 : EMPTY,
+                      std::memory_order_relaxed);
+  }
+  freeHead.store(0, std::memory_order_release);
+  return true;
+}
+
+// acquire(), release() and owns() are kept in IRAM: EventBus::sendFromISR
+// takes a slot from interrupts and returns it when the queue is full
+void *IRAM_ATTR BlockPool::acquire() {
+  if (!blocks) {
+    return nullptr;
+  }
+
+  uint32_t head = freeHead.load(std::memory_order_acquire);
+  while (true) {
+    uint16_t index = head & 0xFFFF;
+    if (index == EMPTY) {
+      return nullptr;
+    }
+
+    uint16_t next = nextFree[index].load(std::memory_order_relaxed);
+    uint32_t newHead = ((head + 0x10000) & 0xFFFF0000) | next;
+    if (freeHead.compare_exchange_weak(head, newHead,
+                                       std::memory_order_acq_rel,
+                                       std::memory_order_acquire)) {
+      inUse.fetch_add(1, std::memory_order_relaxed);
+      return blocks + index * blockSize;
+    }
+  }
+}
+
+void IRAM_ATTR BlockPool::release(void *block) {
+  if (!owns(block)) {
+    return;
+  }
+
+  uint16_t index = (static_cast<uint8_t *>(block) - blocks) / blockSize;
+  uint32_t head = freeHead.load(std::memory_order_relaxed);
+  uint32_t newHead;
+  do {
+    nextFree[index].store(head & 0xFFFF, std::memory_order_relaxed);
+    newHead = ((head + 0x10000) & 0xFFFF0000) | index;
+  } while (!freeHead.compare_exchange_weak(head, newHead,
+                                           std::memory_order_release,
+                                           std::memory_order_relaxed));
+  inUse.fetch_sub(1, std::memory_order_relaxed);
+}
+
+bool IRAM_ATTR BlockPool::owns(const void *block) const {
+  const uint8_t *p = static_cast<const uint8_t *>(block);
+  return blocks && p >= blocks && p < blocks + blockSize * capacity;
+}
+
+// ===== BufferRef Implementation =====
+
+BufferRef::BufferRef(const BufferRef &other) : header(other.header) {
+  if (header) {
+    header->refs.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+BufferRef &BufferRef::operator=(const BufferRef &other) {
+  if (header != other.header) {
+    reset();
+    header = other.header;
+    if (header) {
+      header->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+  return *this;
+}
+
+BufferRef &BufferRef::operator=(BufferRef &&other) noexcept {
+  if (this != &other) {
+    reset();
+    header = other.header;
+    other.header = nullptr;
+  }
+  return *this;
+}
+
+BufferRef BufferRef::acquire(BlockPool &pool) {
+  BufferRef ref;
+  void *block = pool.acquire();
+  if (block) {
+    ref.header = new (block) Header();
+    ref.header->refs.store(1, std::memory_order_relaxed);
+    ref.header->pool = &pool;
+  }
+  return ref;
+}
+
+size_t BufferRef::blockSizeFor(size_t dataSize) {
+  return HEADER_SIZE + dataSize;
+}
+
+void *BufferRef::data() const {
+  return header ? reinterpret_cast<uint8_t *>(header) + HEADER_SIZE : nullptr;
+}
+
+size_t BufferRef::capacity() const {
+  return header ? header->pool->getBlockSize() - HEADER_SIZE : 0;
+}
+
+uint32_t BufferRef::useCount() const {
+  return header ? header->refs.load(std::memory_order_relaxed) : 0;
+}
+
+void BufferRef::reset() {
+  if (!header) {
+    return;
+  }
+
+  // Last reference returns the block; acq_rel orders every holder's writes
+  // before the block is reused
+  if (header->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    BlockPool *pool = header->pool;
+    header->~Header();
+    pool->release(header);
+  }
+  header = nullptr;
+}
+
+} // namespace ESPLooper
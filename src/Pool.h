@@ -0,0 +1,100 @@
+#pragma once
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace ESPLooper {
+
+// Fixed-capacity pool of equally sized blocks.
+// Storage is allocated once by begin(); acquire() and release() are O(1) and
+// lock-free (Treiber stack with an ABA tag), so they are safe to call from any
+// task on either core.
+class BlockPool {
+public:
+    BlockPool();
+    ~BlockPool();
+    
+    // Allocate storage for `count` blocks of `blockSize` bytes, or carve
+    // them from `storage` (at least bytesFor(blockSize, count) bytes, kept
+    // by the caller for the pool's lifetime)
+    bool begin(size_t blockSize, size_t count, void* storage = nullptr);
+    
+    static constexpr size_t bytesFor(size_t blockSize, size_t count) {
+        return alignBlock(blockSize) * count;
+    }
+    bool isEnabled() const { return blocks != nullptr; }
+    
+    // Returns nullptr when the pool is exhausted - never falls back to heap
+    void* acquire();
+    void release(void* block);
+    
+    bool owns(const void* block) const;
+    
+    size_t getBlockSize() const { return blockSize; }
+    size_t getCapacity() const { return capacity; }
+    size_t getInUse() const { return inUse.load(std::memory_order_relaxed); }
+    
+    BlockPool(const BlockPool&) = delete;
+    BlockPool& operator=(const BlockPool&) = delete;
+    
+private:
+    static constexpr uint16_t EMPTY = 0xFFFF;
+    static constexpr size_t MAX_BLOCKS = EMPTY;
+    
+    // Keeps every block word-aligned
+    static constexpr size_t alignBlock(size_t size) {
+        return (size + alignof(max_align_t) - 1) & ~(alignof(max_align_t) - 1);
+    }
+    
+    uint8_t* blocks;
+    bool ownsBlocks;
+    std::atomic<uint16_t>* nextFree;
+    size_t blockSize;
+    size_t capacity;
+    
+    std::atomic<uint32_t> freeHead;  // [tag:16][index:16]
+    std::atomic<uint32_t> inUse;
+};
+
+// Reference-counted handle to a buffer loaned from a BlockPool.
+// Copies share the buffer; it goes back to its pool when the last handle
+// drops. Safe to copy and destroy from any task on either core.
+class BufferRef {
+public:
+    BufferRef() : header(nullptr) {}
+    ~BufferRef() { reset(); }
+    
+    BufferRef(const BufferRef& other);
+    BufferRef(BufferRef&& other) noexcept : header(other.header) { other.header = nullptr; }
+    BufferRef& operator=(const BufferRef& other);
+    BufferRef& operator=(BufferRef&& other) noexcept;
+    
+    // Take a block from `pool`; empty handle when the pool is exhausted
+    static BufferRef acquire(BlockPool& pool);
+    
+    // Block size needed to hold `dataSize` bytes plus the handle's header
+    static size_t blockSizeFor(size_t dataSize);
+    
+    void* data() const;
+    size_t capacity() const;
+    uint32_t useCount() const;
+    
+    template <typename T>
+    T* as() const { return static_cast<T*>(data()); }
+    
+    explicit operator bool() const { return header != nullptr; }
+    void reset();
+    
+private:
+    struct Header {
+        std::atomic<uint32_t> refs;
+        BlockPool* pool;
+    };
+    
+    static constexpr size_t HEADER_SIZE =
+        (sizeof(Header) + alignof(max_align_t) - 1) & ~(alignof(max_align_t) - 1);
+    
+    Header* header;
+};
+
+} // namespace ESPLooper
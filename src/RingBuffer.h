@@ -0,0 +1,116 @@
+#pragma once
+#include <atomic>
+#include <new>
+#include <stddef.h>
+#include <stdint.h>
+
+// Keep producer and consumer indices on separate cache lines
+#ifndef LP_CACHE_LINE_SIZE
+#define LP_CACHE_LINE_SIZE 32
+#endif
+
+namespace ESPLooper {
+
+// Bounded lock-free multi-producer single-consumer ring of pointers.
+// Each cell carries a sequence number (Vyukov): producers claim a cell with
+// one CAS on the tail and publish it with a release store, the consumer
+// never writes shared indices producers spin on. push() is safe from any
+// task on either core and from ISRs; pop() must only be called by the
+// single consumer.
+template <typename T>
+class MpscRing {
+public:
+    MpscRing() : cells(nullptr), mask(0), tail(0), head(0) {}
+    ~MpscRing() { delete[] cells; }
+    
+    // Capacity is rounded up to a power of two
+    bool begin(size_t minCapacity) {
+        if (cells || minCapacity == 0) {
+            return false;
+        }
+        
+        size_t capacity = 1;
+        while (capacity < minCapacity) {
+            capacity <<= 1;
+        }
+        
+        cells = new (std::nothrow) Cell[capacity];
+        if (!cells) {
+            return false;
+        }
+        
+        for (size_t i = 0; i < capacity; i++) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        mask = capacity - 1;
+        return true;
+    }
+    
+    bool isEnabled() const { return cells != nullptr; }
+    
+    // Always inlined so ISR callers keep the whole path in IRAM
+    __attribute__((always_inline)) inline bool push(T* item) {
+        uint32_t pos = tail.load(std::memory_order_relaxed);
+        Cell* cell;
+        
+        while (true) {
+            cell = &cells[pos & mask];
+            uint32_t seq = cell->sequence.load(std::memory_order_acquire);
+            int32_t diff = (int32_t)(seq - pos);
+            
+            if (diff == 0) {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false; // Full
+            } else {
+                pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+        
+        cell->item = item;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+    
+    // Returns false when empty, or when the next cell is claimed but not yet
+    // published - the producer wakes the consumer again once it is
+    bool pop(T*& item) {
+        uint32_t pos = head.load(std::memory_order_relaxed);
+        Cell* cell = &cells[pos & mask];
+        uint32_t seq = cell->sequence.load(std::memory_order_acquire);
+        
+        if ((int32_t)(seq - (pos + 1)) < 0) {
+            return false;
+        }
+        
+        item = cell->item;
+        cell->sequence.store(pos + mask + 1, std::memory_order_release);
+        head.store(pos + 1, std::memory_order_relaxed);
+        return true;
+    }
+    
+    size_t size() const {
+        return tail.load(std::memory_order_relaxed) - head.load(std::memory_order_relaxed);
+    }
+    
+    size_t capacity() const { return cells ? mask + 1 : 0; }
+    
+    MpscRing(const MpscRing&) = delete;
+    MpscRing& operator=(const MpscRing&) = delete;
+    
+private:
+    struct Cell {
+        std::atomic<uint32_t> sequence;
+        T* item;
+    };
+    
+    Cell* cells;
+    uint32_t mask;
+    
+    alignas(LP_CACHE_LINE_SIZE) std::atomic<uint32_t> tail; // Producers
+    alignas(LP_CACHE_LINE_SIZE) std::atomic<uint32_t> head; // Consumer
+};
+
+} // namespace ESPLooper
@@ -0,0 +1,158 @@
+#pragma once
+#include <atomic>
+#include <new>
+#include <stdint.h>
+
+namespace ESPLooper {
+
+// Copy-on-write holder for a read-mostly table (the EventBus listener
+// table, the task registry). Readers pin the current version lock-free with
+// acquire()/release(). A writer takes a copy with edit(), changes it and
+// publish()es it; the version it replaces is retired.
+//
+// Every version counts its own readers, so a retired version is reclaimed
+// as soon as the readers that saw it are gone, no matter how busy the
+// newer versions are, and collect() lets a writer wait for exactly the
+// versions retired before a given epoch.
+//
+// Versions are never freed while the Snapshot exists. A reclaimed one is
+// emptied with T::clear() and kept as a spare for the next edit(), so a
+// reader still holding a stale pointer can't touch freed memory, and edits
+// reuse the old storage instead of allocating a new table each time.
+//
+// Readers may run on any task. Writers (edit, fresh, discard, publish,
+// collect, current, live) must be serialized by the owner.
+template <typename T>
+class Snapshot {
+public:
+    Snapshot() : head(new Version()), retired(nullptr), spares(nullptr), retiredCount(0) {}
+
+    ~Snapshot() {
+        delete head.load();
+        destroy(retired);
+        destroy(spares);
+    }
+
+    // Pin the current version; every acquire() needs one release()
+    const T* acquire() const {
+        while (true) {
+            Version* version = head.load();
+            version->readers.fetch_add(1);
+            // Re-check: the version may have been replaced (and reclaimed)
+            // between the load and the increment
+            if (head.load() == version) {
+                return version;
+            }
+            version->readers.fetch_sub(1);
+        }
+    }
+
+    void release(const T* version) const {
+        static_cast<const Version*>(version)->readers.fetch_sub(1);
+    }
+
+    // Writer's view of the current version
+    const T& current() const { return *head.load(); }
+
+    // The current version itself, for a table whose readers tolerate the
+    // writer updating it in place (IdTable); edit() otherwise
+    T& live() { return *head.load(); }
+
+    // Copy of the current version to modify and publish(), or to hand back
+    // with discard(); nullptr when out of memory
+    T* edit() {
+        Version* version = takeSpare();
+        if (!version) {
+            return new (std::nothrow) Version(current());
+        }
+        static_cast<T&>(*version) = current();
+        return version;
+    }
+
+    // Empty version, for rebuilding a table from scratch
+    T* fresh() {
+        Version* version = takeSpare();
+        return version ? version : new (std::nothrow) Version();
+    }
+
+    void discard(T* version) {
+        static_cast<Version*>(version)->clear();
+        addSpare(static_cast<Version*>(version));
+    }
+
+    // Make `version` current and retire the old one. Returns the epoch the
+    // old version retired at, for collect().
+    uint32_t publish(T* version) {
+        Version* old = head.exchange(static_cast<Version*>(version));
+        old->retiredAt = ++retiredCount;
+        old->next = retired;
+        retired = old;
+        collect(retiredCount);
+        return retiredCount;
+    }
+
+    // Reclaim retired versions nobody reads any more. Returns true once
+    // every version retired at or before `epoch` has been reclaimed.
+    bool collect(uint32_t epoch) {
+        bool done = true;
+        Version** link = &retired;
+        while (Version* version = *link) {
+            if (version->readers.load() == 0) {
+                *link = version->next;
+                version->clear();
+                addSpare(version);
+            } else {
+                if (static_cast<int32_t>(version->retiredAt - epoch) <= 0) {
+                    done = false;
+                }
+                link = &version->next;
+            }
+        }
+        return done;
+    }
+
+    // Epoch of the most recently retired version
+    uint32_t epoch() const { return retiredCount; }
+
+    Snapshot(const Snapshot&) = delete;
+    Snapshot& operator=(const Snapshot&) = delete;
+
+private:
+    struct Version : T {
+        Version() = default;
+        explicit Version(const T& value) : T(value) {}
+
+        mutable std::atomic<uint32_t> readers{0};
+        uint32_t retiredAt = 0;
+        Version* next = nullptr;
+    };
+
+    Version* takeSpare() {
+        Version* version = spares;
+        if (version) {
+            spares = version->next;
+            version->next = nullptr;
+        }
+        return version;
+    }
+
+    void addSpare(Version* version) {
+        version->next = spares;
+        spares = version;
+    }
+
+    static void destroy(Version* list) {
+        while (list) {
+            Version* next = list->next;
+            delete list;
+            list = next;
+        }
+    }
+
+    std::atomic<Version*> head;
+    Version* retired;   // Retired, possibly still read
+    Version* spares;    // Reclaimed, empty, ready for edit()
+    uint32_t retiredCount;
+};
+
+} // namespace ESPLooper
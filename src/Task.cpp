@@ -1,5 +1,7 @@
 #include "Task.h"
 #include "Looper.h"
+#include "TaskStacks.h"
+#include <Arduino.h>
 
 namespace ESPLooper {
 
@@ -7,11 +9,11 @@ namespace ESPLooper {
 
 Task::Task(const char* name, TaskCallback callback, uint32_t stackSize, 
            UBaseType_t priority, BaseType_t coreId)
-    : taskName(name), callback(callback), taskHandle(nullptr), 
+    : taskName(name), callback(std::move(callback)), taskHandle(nullptr), 
       state(TaskState::Created), stackSize(stackSize), 
-      priority(priority), coreId(coreId), shouldRun(true),
+      priority(priority), coreId(coreId), shouldRun(true), worker(nullptr),
       taskId(0), taskIdString(nullptr), enabled(true), 
-      eventsEnabled(false), statesEnabled(false), currentState(tState::Loop) {
+      eventsEnabled(false), statesEnabled(false), setupCalled(false) {
 }
 
 Task::~Task() {
@@ -24,16 +26,16 @@ bool Task::start() {
     }
     
     shouldRun = true;
-    BaseType_t result;
     
-    if (coreId == tskNO_AFFINITY) {
-        result = xTaskCreate(taskWrapper, taskName.c_str(), stackSize, 
-                            this, priority, &taskHandle);
-    } else {
-        result = xTaskCreatePinnedToCore(taskWrapper, taskName.c_str(), stackSize,
-                                         this, priority, &taskHandle, coreId);
+    if (TaskWorkers::isEnabled()) {
+        return TaskWorkers::start(this);
     }
     
+    // Heap-allocated unless LooperConfig::taskStacks reserved static blocks
+    BaseType_t result = TaskStacks::createTask(taskWrapper, taskName.c_str(),
+                                               stackSize, this, priority,
+                                               &taskHandle, coreId);
+    
     if (result == pdPASS) {
         state = TaskState::Running;
         return true;
@@ -48,11 +50,24 @@ bool Task::stop() {
     }
     
     shouldRun = false;
+    
+    // A recycled worker leaves run() and parks for the next task. If run()
+    // has returned on its own, the worker already let go of the task.
+    if (TaskWorkers::isEnabled()) {
+        if (state == TaskState::Paused) {
+            vTaskResume(taskHandle);
+        }
+        state = TaskState::Stopped;
+        bool stopped = TaskWorkers::stop(this);
+        taskHandle = nullptr;
+        return stopped;
+    }
+    
     state = TaskState::Stopped;
     
     // Delete the task
     if (taskHandle) {
-        vTaskDelete(taskHandle);
+        TaskStacks::deleteTask(taskHandle);
         taskHandle = nullptr;
     }
     
@@ -79,6 +94,13 @@ bool Task::resume() {
     return true;
 }
 
+bool Task::pin(std::shared_ptr<Task>& self) {
+    std::weak_ptr<Task> owner = weak_from_this();
+    self = owner.lock();
+    return self || !(owner.owner_before(std::weak_ptr<Task>()) ||
+                     std::weak_ptr<Task>().owner_before(owner));
+}
+
 uint32_t Task::getStackHighWaterMark() const {
     if (taskHandle) {
         return uxTaskGetStackHighWaterMark(taskHandle);
@@ -128,24 +150,21 @@ bool Task::hasStates() const {
     return statesEnabled;
 }
 
-void Task::executeWithState(tState newState) {
+void Task::executeWithState(tState newState, void* eventData) {
+    TaskContext::Scope scope(this, newState, eventData);
+    
     if (!statesEnabled) {
         if (callback) callback();
         return;
     }
     
-    // For Event state, save and restore after callback
+    // Event state is only seen through the context: the task's own loop
+    // may be running on another core meanwhile
     if (newState == tState::Event) {
-        tState prevState = currentState;
-        currentState = newState;
         if (callback) callback();
-        currentState = prevState;
         return;
     }
     
-    // For other states, change and keep the state
-    currentState = newState;
-    
     // Always execute for Exit and Setup states, even if disabled
     // Only check enabled flag for Loop state
     if (callback) {
@@ -157,6 +176,23 @@ void Task::executeWithState(tState newState) {
     }
 }
 
+// ===== TaskContext =====
+
+static thread_local TaskContext context = {nullptr, tState::Loop, nullptr};
+
+const TaskContext& TaskContext::current() {
+    return context;
+}
+
+TaskContext::Scope::Scope(Task* task, tState state, void* eventData)
+    : saved(context) {
+    context = {task, state, eventData};
+}
+
+TaskContext::Scope::~Scope() {
+    context = saved;
+}
+
 void Task::taskWrapper(void* parameter) {
     Task* task = static_cast<Task*>(parameter);
     if (task) {
@@ -174,67 +210,273 @@ void Task::run() {
     }
 }
 
+void Task::wake() {
+    xTaskNotifyGive(taskHandle);
+}
+
 // ===== TimerTask Implementation =====
 
 TimerTask::TimerTask(const char* name, TaskCallback callback, uint32_t periodMs,
                      bool autoStart, uint32_t stackSize, UBaseType_t priority,
                      BaseType_t coreId)
     : Task(name, callback, stackSize, priority, coreId),
-      periodMs(periodMs), autoStart(autoStart) {
+      periodMs(periodMs), autoStart(autoStart), wheel(nullptr) {
     
     if (autoStart) {
         start();
     }
 }
 
+TimerTask::~TimerTask() {
+    // Task::~Task can't reach the override
+    stop();
+}
+
 void TimerTask::setPeriod(uint32_t ms) {
     periodMs = ms;
+    
+    // Own-task timers pick the new period up after their next callback
+    if (wheel && state == TaskState::Running) {
+        wheel->schedule(this, periodTicks());
+    }
+}
+
+TickType_t TimerTask::periodTicks() const {
+    TickType_t ticks = pdMS_TO_TICKS(periodMs);
+    return ticks > 0 ? ticks : 1;
 }
 
 bool TimerTask::start() {
     if (!autoStart && state == TaskState::Created) {
         autoStart = true;
     }
-    return Task::start();
+    
+    // Services only exist in TimerMode::Wheel (created by Looper::begin)
+    if (!wheel) {
+        wheel = TimerService::forCore(coreId);
+    }
+    if (!wheel) {
+        return Task::start();
+    }
+    
+    if (state == TaskState::Running) {
+        return false;
+    }
+    shouldRun = true;
+    state = TaskState::Running;
+    wheel->schedule(this, 0);
+    return true;
+}
+
+bool TimerTask::stop() {
+    if (!wheel) {
+        return Task::stop();
+    }
+    
+    if (state == TaskState::Stopped) {
+        return false;
+    }
+    shouldRun = false;
+    state = TaskState::Stopped;
+    wheel->cancel(this);
+    return true;
+}
+
+bool TimerTask::pause() {
+    if (!wheel) {
+        return Task::pause();
+    }
+    
+    if (state != TaskState::Running) {
+        return false;
+    }
+    state = TaskState::Paused;
+    wheel->cancel(this);
+    return true;
+}
+
+bool TimerTask::resume() {
+    if (!wheel) {
+        return Task::resume();
+    }
+    
+    if (state != TaskState::Paused) {
+        return false;
+    }
+    state = TaskState::Running;
+    wheel->schedule(this, periodTicks());
+    return true;
+}
+
+void TimerTask::fire() {
+    if (enabled) {
+        executeWithState(tState::Loop);
+    }
 }
 
 void TimerTask::run() {
-    TickType_t lastWakeTime = xTaskGetTickCount();
-    const TickType_t period = pdMS_TO_TICKS(periodMs);
+    TickType_t nextWake = xTaskGetTickCount();
     
     while (shouldRun) {
-        if (enabled) {
-            if (statesEnabled) {
-                executeWithState(tState::Loop);
-            } else if (callback) {
-                callback();
-            }
+        fire();
+        
+        // Like vTaskDelayUntil(), but stop() can wake us
+        nextWake += periodTicks();
+        TickType_t now = xTaskGetTickCount();
+        if ((int32_t)(nextWake - now) <= 0) {
+            taskYIELD();
+        }
+        while (shouldRun && (int32_t)(nextWake - now) > 0) {
+            ulTaskNotifyTake(pdTRUE, nextWake - now);
+            now = xTaskGetTickCount();
         }
-        vTaskDelayUntil(&lastWakeTime, period);
     }
 }
 
 // ===== ListenerTask Implementation =====
 
 ListenerTask::ListenerTask(const char* name, uint32_t eventId, EventCallback callback,
-                           uint32_t stackSize, UBaseType_t priority, BaseType_t coreId)
+                           uint32_t stackSize, UBaseType_t priority, BaseType_t coreId,
+                           size_t mailboxDepth)
     : Task(name, nullptr, stackSize, priority, coreId),
-      listenEventId(eventId), eventCallback(callback) {
+      listenEventId(eventId), eventCallback(std::move(callback)), mailbox(nullptr),
+      droppedEvents(0), exited(nullptr), exitClaimed(false) {
+    
+    if (mailboxDepth > 0) {
+        mailbox = xQueueCreate(mailboxDepth, sizeof(Event*));
+        exited = xSemaphoreCreateBinary();
+    }
     
     // Register with EventBus
-    EventBus::getInstance().on(eventId, [this](const Event& evt) {
+    subscription = EventBus::getInstance().on(eventId, [this](const Event& evt) {
+        deliver(evt);
+    }, coreId);
+    
+    // Without a mailbox there is no execution loop: events are dispatched
+    // by the EventBus
+    if (mailbox) {
+        start();
+    }
+}
+
+ListenerTask::~ListenerTask() {
+    // Remove only our own subscription, then make sure the dispatcher is
+    // no longer inside the callback that captured `this`. On a dispatcher
+    // synchronize() can't wait; deliver() has already kept us alive until
+    // our own callback returned.
+    EventBus::getInstance().off(subscription);
+    EventBus::getInstance().synchronize();
+    
+    if (mailbox) {
+        stop();
+        
+        Event* pending;
+        while (xQueueReceive(mailbox, &pending, 0) == pdTRUE) {
+            if (pending) {
+                EventBus::getInstance().releaseEvent(pending);
+            }
+        }
+        vQueueDelete(mailbox);
+    }
+    if (exited) {
+        vSemaphoreDelete(exited);
+    }
+}
+
+bool ListenerTask::stop() {
+    // Recycled workers already wait for run(); a listener stopping itself
+    // from its own callback never returns from here
+    if (!mailbox || !exited || TaskWorkers::isEnabled() ||
+        state == TaskState::Stopped || !taskHandle ||
+        xTaskGetCurrentTaskHandle() == taskHandle) {
+        return Task::stop();
+    }
+    
+    // Deleting the task outright could catch run() inside a callback,
+    // holding a retained event: make it return instead
+    shouldRun = false;
+    if (state == TaskState::Paused) {
+        vTaskResume(taskHandle);
+    }
+    state = TaskState::Stopped;
+    wake();
+    
+    if (xSemaphoreTake(exited, pdMS_TO_TICKS(LP_TASK_STOP_TIMEOUT_MS)) != pdTRUE) {
+        if (!exitClaimed.exchange(true)) {
+            log_w("Listener \"%s\" did not stop within %u ms, deleting it",
+                  getName(), (unsigned)LP_TASK_STOP_TIMEOUT_MS);
+            TaskStacks::deleteTask(taskHandle);
+        } else {
+            // run() returned just now and is about to signal
+            xSemaphoreTake(exited, portMAX_DELAY);
+        }
+    }
+    
+    // run() deletes its own task once it has signalled
+    taskHandle = nullptr;
+    return true;
+}
+
+void ListenerTask::deliver(const Event& evt) {
+    // Pin the listener for the whole call. A callback that removes its own
+    // listener then only drops the Looper's reference, and the listener is
+    // destroyed here after the callback has returned instead of under it.
+    std::shared_ptr<Task> self;
+    if (!pin(self)) {
+        return;
+    }
+    
+    if (!mailbox) {
         if (eventCallback) {
+            TaskContext::Scope scope(this, tState::Event, evt.data);
             eventCallback(evt);
         }
-    });
+        return;
+    }
+    
+    // Never block the dispatcher on a full mailbox
+    EventBus& bus = EventBus::getInstance();
+    Event* held = bus.retainEvent(evt);
+    if (xQueueSend(mailbox, &held, 0) != pdTRUE) {
+        bus.releaseEvent(held);
+        droppedEvents = droppedEvents + 1;
+    }
+}
+
+void ListenerTask::run() {
+    EventBus& bus = EventBus::getInstance();
+    Event* evt;
+    
+    exitClaimed = false;
+    while (shouldRun) {
+        // Null is the wake() marker
+        if (xQueueReceive(mailbox, &evt, portMAX_DELAY) == pdTRUE && evt) {
+            if (eventCallback) {
+                TaskContext::Scope scope(this, tState::Event, evt->data);
+                eventCallback(*evt);
+            }
+            bus.releaseEvent(evt);
+        }
+    }
     
-    // ListenerTask doesn't need its own execution loop
-    // Events are dispatched by the EventBus
+    // Tell stop() we're out. If it gave up waiting it is deleting this
+    // task right now; don't touch `this` again either way.
+    if (!TaskWorkers::isEnabled()) {
+        if (exitClaimed.exchange(true)) {
+            vTaskSuspend(nullptr);
+        }
+        xSemaphoreGive(exited);
+    }
 }
 
-ListenerTask::~ListenerTask() {
-    // Note: We don't unregister from EventBus here to avoid issues
-    // if multiple listeners use the same event ID
+void ListenerTask::wake() {
+    // A full mailbox means run() isn't blocked anyway
+    Event* marker = nullptr;
+    xQueueSendToFront(mailbox, &marker, 0);
+}
+
+size_t ListenerTask::getPendingEvents() const {
+    return mailbox ? uxQueueMessagesWaiting(mailbox) : 0;
 }
 
 } // namespace ESPLooper
\ No newline at end of file
@@ -1,9 +1,20 @@
 #pragma once
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
-#include <functional>
+#include <freertos/semphr.h>
+#include <atomic>
+#include <memory>
 #include <string>
 #include "Event.h"
+#include "Function.h"
+#include "TaskWorkers.h"
+#include "TimerService.h"
+
+// How long stop() waits for a task's loop to return before it deletes the
+// FreeRTOS task anyway
+#ifndef LP_TASK_STOP_TIMEOUT_MS
+#define LP_TASK_STOP_TIMEOUT_MS 1000
+#endif
 
 // Task execution state (Setup/Loop/Event/Exit) - Global scope for easy access
 enum class tState {
@@ -22,9 +33,12 @@ enum class TaskState {
     Stopped
 };
 
-class Task {
+// Tasks are owned through std::shared_ptr (Looper's list, getTask());
+// code that calls back into a task it doesn't own pins it with
+// weak_from_this() for the duration of the call.
+class Task : public std::enable_shared_from_this<Task> {
 public:
-    using TaskCallback = std::function<void()>;
+    using TaskCallback = InplaceFunction<void()>;
     
     Task(const char* name, 
          TaskCallback callback,
@@ -75,6 +89,13 @@ public:
     // Statistics
     uint32_t getStackHighWaterMark() const;
     
+    // Keep the task alive across a callback run for it by a dispatcher or
+    // service task: a callback that removes its own task then only drops
+    // the Looper's reference. False when the task is owned but its last
+    // reference is already gone (it's being destroyed); a task not owned
+    // by a shared_ptr is left unpinned and reported alive.
+    bool pin(std::shared_ptr<Task>& self);
+    
 protected:
     std::string taskName;
     TaskCallback callback;
@@ -84,6 +105,7 @@ protected:
     UBaseType_t priority;
     BaseType_t coreId;
     volatile bool shouldRun;
+    TaskWorker* worker;        // Recycled FreeRTOS task running us, if any
     
     // Original Looper state management
     uint32_t taskId;           // Hash ID
@@ -91,19 +113,55 @@ protected:
     bool enabled;
     bool eventsEnabled;
     bool statesEnabled;
-    tState currentState;
     bool setupCalled;          // Track if Setup has been called
     
     static void taskWrapper(void* parameter);
     virtual void run();
     
-    // State execution wrapper
-    void executeWithState(tState state);
+    // Cut short whatever run() is blocked on, so it sees shouldRun == false
+    virtual void wake();
+    
+    // State execution wrapper; installs the TaskContext for the callback
+    void executeWithState(tState state, void* eventData = nullptr);
     
     friend class Looper;
+    friend class TaskWorkers;
+};
+
+// What the calling FreeRTOS task is executing right now. Every callback
+// the framework runs is wrapped in a Scope, so Looper::thisState(),
+// eventData() and thisTaskName() are a thread-local read instead of a
+// search, and a dispatcher delivering an event on one core never changes
+// what a task on the other core sees.
+struct TaskContext {
+    Task* task;
+    tState state;
+    void* eventData;
+    
+    // Context of the caller; task is null outside framework callbacks
+    static const TaskContext& current();
+    
+    class Scope;
+};
+
+// Installs a context for its lifetime and restores the enclosing one
+// (callbacks nest, e.g. removeTask() running another task's Exit)
+class TaskContext::Scope {
+public:
+    Scope(Task* task, tState state, void* eventData = nullptr);
+    ~Scope();
+    
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+    
+private:
+    TaskContext saved;
 };
 
 // Timer-based periodic task
+// Runs in its own FreeRTOS task by default. With TimerMode::Wheel it has no
+// task of its own: its callback runs on the TimerService of its core and
+// stackSize/priority are not used.
 class TimerTask : public Task {
 public:
     TimerTask(const char* name,
@@ -114,40 +172,75 @@ public:
               UBaseType_t priority = 1,
               BaseType_t coreId = tskNO_AFFINITY);
     
-    ~TimerTask() override = default;
+    ~TimerTask() override;
     
     void setPeriod(uint32_t ms);
     uint32_t getPeriod() const { return periodMs; }
     
     bool start() override;
+    bool stop() override;
+    bool pause() override;
+    bool resume() override;
     bool isTimer() const override { return true; }
     
+    // True when scheduled by a TimerService rather than its own task
+    bool onWheel() const { return wheel != nullptr; }
+    
 protected:
     void run() override;
-    uint32_t periodMs;
+    void fire();
+    TickType_t periodTicks() const;
+    
+    volatile uint32_t periodMs;
     bool autoStart;
+    TimerService* wheel;
+    TimerNode wheelNode;
+    
+    friend class TimerService;
 };
 
 // Event listener task
+// With mailboxDepth == 0 the callback runs on the event dispatcher. With a
+// mailbox the listener owns a FreeRTOS task on its requested core and
+// priority; the dispatcher only drops events into the bounded mailbox, so a
+// slow listener never holds up the others.
 class ListenerTask : public Task {
 public:
-    using EventCallback = std::function<void(const Event&)>;
+    using EventCallback = InplaceFunction<void(const Event&)>;
     
     ListenerTask(const char* name,
                  uint32_t eventId,
                  EventCallback callback,
                  uint32_t stackSize = 4096,
                  UBaseType_t priority = 1,
-                 BaseType_t coreId = tskNO_AFFINITY);
+                 BaseType_t coreId = tskNO_AFFINITY,
+                 size_t mailboxDepth = 0);
     
     ~ListenerTask() override;
     
+    // A mailbox listener's loop finishes the event it holds and returns
+    // before its task is deleted (waits up to LP_TASK_STOP_TIMEOUT_MS)
+    bool stop() override;
+    
     uint32_t getEventId() const { return listenEventId; }
     bool isListener() const override { return true; }
     
+    bool hasMailbox() const { return mailbox != nullptr; }
+    size_t getPendingEvents() const;
+    uint32_t getDroppedEvents() const { return droppedEvents; }
+    
 protected:
+    void run() override;
+    void wake() override;
+    void deliver(const Event& evt);
+    
     uint32_t listenEventId;
     EventCallback eventCallback;
+    ListenerHandle subscription;
+    QueueHandle_t mailbox;
+    volatile uint32_t droppedEvents;
+    SemaphoreHandle_t exited;        // Given when run() has returned
+    std::atomic<bool> exitClaimed;   // Set by whichever of run()/stop() ends the task
 };
 
 } // namespace ESPLooper
\ No newline at end of file
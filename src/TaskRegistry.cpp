@@ -0,0 +1,64 @@
+#include "TaskRegistry.h"
+#include "Task.h"
+#include <cstring>
+
+namespace ESPLooper {
+
+TaskRegistry::TaskRegistry() : collisions(0), duplicates(0) {
+  writeMutex = xSemaphoreCreateMutex();
+}
+
+TaskRegistry::~TaskRegistry() {
+  if (writeMutex) {
+    vSemaphoreDelete(writeMutex);
+  }
+}
+
+TaskRegistry::InsertResult
+TaskRegistry::insert(uint32_t id, const std::shared_ptr<Task> &task) {
+  InsertResult result = InsertResult::NoMemory;
+
+  if (xSemaphoreTake(writeMutex, portMAX_DELAY)) {
+    std::shared_ptr<Task> replaced;
+    if (table.insert(id, task, &replaced)) {
+      if (!replaced) {
+        result = InsertResult::Added;
+      } else if (strcmp(replaced->getIdString(), task->getIdString()) == 0) {
+        result = InsertResult::Duplicate;
+        duplicates++;
+      } else {
+        result = InsertResult::Collision;
+        collisions++;
+      }
+    }
+    xSemaphoreGive(writeMutex);
+  }
+
+  return result;
+}
+
+void TaskRegistry::remove(uint32_t id, const Task *task) {
+  if (xSemaphoreTake(writeMutex, portMAX_DELAY)) {
+    table.erase(id, task);
+    xSemaphoreGive(writeMutex);
+  }
+}
+
+TaskRegistry::Stats TaskRegistry::getStats() {
+  Stats stats = {};
+
+  if (xSemaphoreTake(writeMutex, portMAX_DELAY)) {
+    IdTable<Task>::Stats tableStats = table.getStats();
+    stats.tasks = tableStats.entries;
+    stats.slots = tableStats.slots;
+    stats.longestProbe = tableStats.longestProbe;
+    stats.rebuilds = tableStats.rebuilds;
+    stats.collisions = collisions;
+    stats.duplicates = duplicates;
+    xSemaphoreGive(writeMutex);
+  }
+
+  return stats;
+}
+
+} // namespace ESPLooper
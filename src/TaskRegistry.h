@@ -0,0 +1,59 @@
+#pragma once
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include "IdTable.h"
+#include <memory>
+#include <stdint.h>
+
+namespace ESPLooper {
+
+class Task;
+
+// Tasks by ID (EVENT_ID of their name) for Looper::getTask() and event
+// routing.
+//
+// An IdTable: find() reads it lock-free and without allocating, so the
+// dispatcher's per-event probe never waits for add/remove, and add/remove
+// update it in place instead of copying it. A task registered under an ID
+// that is already taken replaces the earlier task, as the task map did.
+class TaskRegistry {
+public:
+    enum class InsertResult : uint8_t {
+        Added,
+        Duplicate, // Replaced a task registered under the same name
+        Collision, // Replaced a task whose different name has the same ID
+        NoMemory   // Not registered
+    };
+
+    TaskRegistry();
+    ~TaskRegistry();
+
+    InsertResult insert(uint32_t id, const std::shared_ptr<Task>& task);
+
+    // Remove the entry for `id` if it is `task` (not a task that replaced it)
+    void remove(uint32_t id, const Task* task);
+
+    // Lock-free, from any task on either core
+    std::shared_ptr<Task> find(uint32_t id) { return table.find(id); }
+
+    struct Stats {
+        size_t tasks;
+        size_t slots;
+        size_t longestProbe;  // Worst-case slots visited by find()
+        uint32_t rebuilds;    // Times the table was copied to grow or shrink
+        uint32_t collisions;  // Tasks replaced by one with another name and the same ID
+        uint32_t duplicates;  // Tasks replaced by one with the same name
+    };
+    Stats getStats();
+
+    TaskRegistry(const TaskRegistry&) = delete;
+    TaskRegistry& operator=(const TaskRegistry&) = delete;
+
+private:
+    IdTable<Task> table;        // Writes guarded by writeMutex
+    SemaphoreHandle_t writeMutex;
+    uint32_t collisions;
+    uint32_t duplicates;
+};
+
+} // namespace ESPLooper
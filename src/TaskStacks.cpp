@@ -0,0 +1,238 @@
+#include "TaskStacks.h"
+#include <Arduino.h>
+#include <atomic>
+#include <esp_freertos_hooks.h>
+#include <esp_heap_caps.h>
+#include <new>
+
+namespace ESPLooper {
+
+static BlockPool pools[LP_TASK_STACK_CLASSES];
+static uint32_t poolStackSizes[LP_TASK_STACK_CLASSES];
+static uint8_t bySize[LP_TASK_STACK_CLASSES]; // Pool indexes, smallest first
+static size_t classCount = 0;
+static bool strictPool = false;
+
+static std::atomic<uint32_t> staticTasks{0};
+static std::atomic<uint32_t> heapFallbacks{0};
+static std::atomic<uint32_t> failedTasks{0};
+
+bool TaskStacks::addClass(uint32_t stackSize, size_t count, void *storage) {
+  if (classCount == LP_TASK_STACK_CLASSES || stackSize == 0 || count == 0) {
+    return false;
+  }
+  if (LP_TASK_STACKS_TLS_INDEX >= configNUM_THREAD_LOCAL_STORAGE_POINTERS) {
+    log_w("Static task stacks need TLS pointer %d; set "
+          "CONFIG_FREERTOS_THREAD_LOCAL_STORAGE_POINTERS to %d or more",
+          LP_TASK_STACKS_TLS_INDEX, LP_TASK_STACKS_TLS_INDEX + 1);
+    return false;
+  }
+
+  // Task stacks must not end up in PSRAM
+  bool allocated = storage == nullptr;
+  if (allocated) {
+    storage = heap_caps_malloc(bytesFor(stackSize, count),
+                               MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (!storage) {
+      return false;
+    }
+  }
+
+  size_t index = classCount;
+  if (!pools[index].begin(blockSize(stackSize), count, storage)) {
+    if (allocated) {
+      heap_caps_free(storage);
+    }
+    return false;
+  }
+  poolStackSizes[index] = stackSize;
+
+  size_t pos = index;
+  while (pos > 0 && poolStackSizes[bySize[pos - 1]] > stackSize) {
+    bySize[pos] = bySize[pos - 1];
+    pos--;
+  }
+  bySize[pos] = index;
+  classCount++;
+
+  // Tasks that delete themselves are cleaned up by the idle task
+  if (classCount == 1) {
+    for (UBaseType_t core = 0; core < portNUM_PROCESSORS; core++) {
+      if (esp_register_freertos_idle_hook_for_cpu(onIdle, core) != ESP_OK) {
+        log_w("No idle hook on core %u: blocks of tasks that delete "
+              "themselves there won't be returned",
+              (unsigned)core);
+      }
+    }
+  }
+  return true;
+}
+
+void TaskStacks::setStrict(bool strict) { strictPool = strict; }
+
+bool TaskStacks::isEnabled() { return classCount > 0; }
+
+BaseType_t TaskStacks::createTask(TaskFunction_t function, const char *name,
+                                  uint32_t stackSize, void *parameter,
+                                  UBaseType_t priority, TaskHandle_t *handle,
+                                  BaseType_t coreId) {
+  reclaim();
+
+  BlockPool *pool = nullptr;
+  void *block = nullptr;
+  uint32_t blockStack = 0;
+  for (size_t i = 0; i < classCount && !block; i++) {
+    uint8_t index = bySize[i];
+    if (poolStackSizes[index] >= stackSize) {
+      pool = &pools[index];
+      blockStack = poolStackSizes[index];
+      block = pool->acquire();
+    }
+  }
+
+  if (!block) {
+    if (isEnabled() && strictPool) {
+      failedTasks.fetch_add(1, std::memory_order_relaxed);
+      return pdFAIL;
+    }
+    if (isEnabled()) {
+      heapFallbacks.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (coreId == tskNO_AFFINITY) {
+      return xTaskCreate(function, name, stackSize, parameter, priority,
+                         handle);
+    }
+    return xTaskCreatePinnedToCore(function, name, stackSize, parameter,
+                                   priority, handle, coreId);
+  }
+
+  Header *header = new (block) Header();
+  header->function = function;
+  header->parameter = parameter;
+  header->pool = pool;
+  StackType_t *stack = reinterpret_cast<StackType_t *>(
+      static_cast<uint8_t *>(block) + headerSize());
+  uint32_t depth = blockStack / sizeof(StackType_t);
+
+  TaskHandle_t created;
+  if (coreId == tskNO_AFFINITY) {
+    created = xTaskCreateStatic(entry, name, depth, header, priority, stack,
+                                &header->tcb);
+  } else {
+    created = xTaskCreateStaticPinnedToCore(entry, name, depth, header,
+                                            priority, stack, &header->tcb,
+                                            coreId);
+  }
+  if (!created) {
+    pool->release(block);
+    failedTasks.fetch_add(1, std::memory_order_relaxed);
+    return pdFAIL;
+  }
+
+  // Also set by entry(): a task deleted before it first runs must still
+  // return its block. Setting it twice writes the same values
+  vTaskSetThreadLocalStoragePointerAndDelCallback(
+      created, LP_TASK_STACKS_TLS_INDEX, header, onTaskDeleted);
+  staticTasks.fetch_add(1, std::memory_order_relaxed);
+  if (handle) {
+    *handle = created;
+  }
+  return pdPASS;
+}
+
+void TaskStacks::deleteTask(TaskHandle_t task) {
+  vTaskDelete(task);
+  reclaim();
+}
+
+void TaskStacks::entry(void *block) {
+  // The task may get here, finish and delete itself before createTask()
+  // returns on a lower-priority creator
+  Header *header = static_cast<Header *>(block);
+  vTaskSetThreadLocalStoragePointerAndDelCallback(
+      nullptr, LP_TASK_STACKS_TLS_INDEX, header, onTaskDeleted);
+  header->function(header->parameter);
+}
+
+void TaskStacks::onTaskDeleted(int, void *block) {
+  // Runs inside prvDeleteTCB() (possibly on the idle task), which still
+  // touches the TCB afterwards: only queue the block
+  Header *header = static_cast<Header *>(block);
+  TaskHandle_t self = xTaskGetCurrentTaskHandle();
+  TaskHandle_t dying = reinterpret_cast<TaskHandle_t>(&header->tcb);
+  header->deleter = self;
+  portENTER_CRITICAL(&deletedLock);
+  // Blocks the dying task queued would otherwise wait for it forever
+  for (Header *queued = deleted; queued; queued = queued->nextDeleted) {
+    if (queued->deleter == dying) {
+      queued->deleter = self;
+    }
+  }
+  header->nextDeleted = deleted;
+  deleted = header;
+  pending.fetch_add(1, std::memory_order_relaxed);
+  portEXIT_CRITICAL(&deletedLock);
+}
+
+bool TaskStacks::onIdle() {
+  // After the idle task's cleanup pass
+  reclaim();
+  return true;
+}
+
+void TaskStacks::reclaim() {
+  if (!pending.load(std::memory_order_relaxed)) {
+    return;
+  }
+
+  // A block this task queued: its prvDeleteTCB() has returned, since this
+  // task is here now. Blocks other tasks queued wait for them.
+  TaskHandle_t self = xTaskGetCurrentTaskHandle();
+  Header *done = nullptr;
+  portENTER_CRITICAL(&deletedLock);
+  for (Header **link = &deleted; *link;) {
+    Header *header = *link;
+    if (header->deleter == self) {
+      *link = header->nextDeleted;
+      header->nextDeleted = done;
+      done = header;
+      pending.fetch_sub(1, std::memory_order_relaxed);
+    } else {
+      link = &header->nextDeleted;
+    }
+  }
+  portEXIT_CRITICAL(&deletedLock);
+
+  while (done) {
+    Header *next = done->nextDeleted;
+    BlockPool *pool = done->pool;
+    done->~Header();
+    pool->release(done);
+    done = next;
+  }
+}
+
+size_t TaskStacks::getClassCount() { return classCount; }
+
+TaskStacks::ClassStats TaskStacks::getClassStats(size_t index) {
+  reclaim();
+
+  ClassStats stats = {};
+  if (index < classCount) {
+    const BlockPool &pool = pools[bySize[index]];
+    stats.stackSize = poolStackSizes[bySize[index]];
+    stats.capacity = pool.getCapacity();
+    stats.inUse = pool.getInUse();
+  }
+  return stats;
+}
+
+TaskStacks::Stats TaskStacks::getStats() {
+  Stats stats;
+  stats.staticTasks = staticTasks.load(std::memory_order_relaxed);
+  stats.heapFallbacks = heapFallbacks.load(std::memory_order_relaxed);
+  stats.failed = failedTasks.load(std::memory_order_relaxed);
+  return stats;
+}
+
+} // namespace ESPLooper
@@ -0,0 +1,124 @@
+#pragma once
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include "Pool.h"
+
+// Most stack size classes LooperConfig::taskStacks can hold
+#ifndef LP_TASK_STACK_CLASSES
+#define LP_TASK_STACK_CLASSES 4
+#endif
+
+// Thread-local storage pointer whose deletion callback tells TaskStacks
+// FreeRTOS is done with a task's TCB. Index 0 belongs to pthread, so static
+// task stacks need CONFIG_FREERTOS_THREAD_LOCAL_STORAGE_POINTERS >= 2
+#ifndef LP_TASK_STACKS_TLS_INDEX
+#define LP_TASK_STACKS_TLS_INDEX 1
+#endif
+static_assert(LP_TASK_STACKS_TLS_INDEX >= 1,
+              "TLS index 0 is used by pthread; pick another LP_TASK_STACKS_TLS_INDEX");
+
+namespace ESPLooper {
+
+// `count` stacks of up to `stackSize` bytes (count 0 = unused entry)
+struct TaskStackClass {
+    uint32_t stackSize;
+    size_t count;
+};
+
+// Stack and TCB memory for the tasks Task::start() creates.
+//
+// Each size class is a BlockPool whose blocks hold a TCB and a stack, and
+// tasks are created on them with xTaskCreateStatic. The memory is reserved
+// once, so timers and threads that come and go never fragment the heap.
+// FreeRTOS calls the TLS deletion callback from inside prvDeleteTCB() and
+// still reads the TCB after it, so the callback only queues the block with
+// the task that is deleting it. Once that same task runs anything else,
+// its prvDeleteTCB() has returned and the block goes back to its class:
+// - a task that deleted itself is cleaned up by the idle task, whose idle
+//   hook returns the block
+// - deleteTask() returns it as soon as vTaskDelete() does
+// - otherwise the deleting task returns it on its next createTask(),
+//   deleteTask() or stats call
+// Without any class, tasks use the heap as usual.
+class TaskStacks {
+public:
+    // Add a class of `count` blocks for stacks up to stackSize bytes. The
+    // blocks come from internal RAM, or from `storage` (bytesFor() bytes,
+    // e.g. a static array). Call before begin() creates tasks. Fails when
+    // FreeRTOS has no TLS pointer to spare (see LP_TASK_STACKS_TLS_INDEX)
+    static bool addClass(uint32_t stackSize, size_t count, void* storage = nullptr);
+
+    static constexpr size_t bytesFor(uint32_t stackSize, size_t count) {
+        return BlockPool::bytesFor(blockSize(stackSize), count);
+    }
+
+    // With a strict pool a task fails to start when no block fits instead
+    // of taking its stack from the heap
+    static void setStrict(bool strict);
+
+    static bool isEnabled();
+
+    // Drop-in for xTaskCreatePinnedToCore(): uses the smallest class with a
+    // free block that fits stackSize (the task gets the whole block)
+    static BaseType_t createTask(TaskFunction_t function, const char* name,
+                                 uint32_t stackSize, void* parameter,
+                                 UBaseType_t priority, TaskHandle_t* handle,
+                                 BaseType_t coreId);
+
+    // vTaskDelete() that returns the task's block right away. Use it rather
+    // than a plain vTaskDelete() on another task created by createTask()
+    static void deleteTask(TaskHandle_t task);
+
+    struct ClassStats {
+        uint32_t stackSize;
+        size_t capacity;
+        size_t inUse;
+    };
+    static size_t getClassCount();
+    static ClassStats getClassStats(size_t index);
+
+    struct Stats {
+        uint32_t staticTasks;    // Tasks created on a block
+        uint32_t heapFallbacks;  // No block fitted - stack came from the heap
+        uint32_t failed;         // Strict pool had no block, or create failed
+    };
+    static Stats getStats();
+
+private:
+    struct Header;
+
+    static constexpr size_t headerSize();
+    static constexpr size_t blockSize(uint32_t stackSize) {
+        return headerSize() + stackSize;
+    }
+
+    static void entry(void* block);
+    static void onTaskDeleted(int, void* block);
+    static bool onIdle();
+    static void reclaim();
+
+    // Blocks whose task is being deleted, for reclaim(), under deletedLock
+    static inline Header* deleted = nullptr;
+    static inline portMUX_TYPE deletedLock = portMUX_INITIALIZER_UNLOCKED;
+    static inline std::atomic<size_t> pending{0}; // Length of `deleted`
+};
+
+// Header, TCB and stack share one block; the header is rounded up so the
+// TCB and stack stay aligned
+struct TaskStacks::Header {
+    TaskFunction_t function;
+    void* parameter;
+    BlockPool* pool;
+    Header* nextDeleted;
+    TaskHandle_t deleter;  // Task whose prvDeleteTCB() queued the block
+    StaticTask_t tcb;
+};
+
+constexpr size_t TaskStacks::headerSize() {
+    return (sizeof(Header) + alignof(max_align_t) - 1) & ~(alignof(max_align_t) - 1);
+}
+
+} // namespace ESPLooper
@@ -0,0 +1,232 @@
+#include "TaskWorkers.h"
+#include "Task.h"
+#include "TaskStacks.h"
+#include <Arduino.h>
+#include <string.h>
+
+namespace ESPLooper {
+
+struct TaskWorker {
+  TaskHandle_t handle;
+  uint32_t stackSize;
+  BaseType_t coreId;
+  std::atomic<Task *> job;  // Set by start(); cleared by whichever of the
+                            // worker (run() returned) and a timed-out
+                            // stop() gets there first
+  SemaphoreHandle_t idle;   // Given when run() has returned for a stop()
+  TaskWorker *next;         // Parked list
+};
+
+static portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+static TaskWorker *parked = nullptr;
+static size_t parkedCount = 0;
+static size_t maxParked = 0;
+
+static std::atomic<uint32_t> createdWorkers{0};
+static std::atomic<uint32_t> reusedWorkers{0};
+static std::atomic<uint32_t> deletedWorkers{0};
+
+void TaskWorkers::configure(size_t limit) { maxParked = limit; }
+
+bool TaskWorkers::isEnabled() { return maxParked > 0; }
+
+bool TaskWorkers::start(Task *task) {
+  TaskWorker *worker = nullptr;
+
+  taskENTER_CRITICAL(&lock);
+  for (TaskWorker **link = &parked; *link; link = &(*link)->next) {
+    if ((*link)->stackSize == task->stackSize &&
+        (*link)->coreId == task->coreId) {
+      worker = *link;
+      *link = worker->next;
+      parkedCount--;
+      break;
+    }
+  }
+  taskEXIT_CRITICAL(&lock);
+
+  if (worker) {
+    // The TCB keeps its name in place; the worker is parked, so nothing
+    // else writes it
+    strlcpy(pcTaskGetName(worker->handle), task->getName(),
+            configMAX_TASK_NAME_LEN);
+    vTaskPrioritySet(worker->handle, task->priority);
+    reusedWorkers.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    // Created idle: it waits for the job like a parked worker
+    worker = new (std::nothrow) TaskWorker();
+    if (!worker) {
+      return false;
+    }
+    worker->idle = xSemaphoreCreateBinary();
+    worker->stackSize = task->stackSize;
+    worker->coreId = task->coreId;
+    worker->job.store(nullptr);
+    if (!worker->idle ||
+        TaskStacks::createTask(workerTask, task->getName(), task->stackSize,
+                               worker, task->priority, &worker->handle,
+                               task->coreId) != pdPASS) {
+      if (worker->idle) {
+        vSemaphoreDelete(worker->idle);
+      }
+      delete worker;
+      return false;
+    }
+    createdWorkers.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Before run() starts, which may return at once and let go of the task
+  taskENTER_CRITICAL(&lock);
+  task->worker = worker;
+  task->taskHandle = worker->handle;
+  task->state = TaskState::Running;
+  taskEXIT_CRITICAL(&lock);
+
+  worker->job.store(task);
+  xTaskNotifyGive(worker->handle);
+  return true;
+}
+
+bool TaskWorkers::stop(Task *task) {
+  // Take the task from its worker, unless run() already returned and the
+  // worker let go of it
+  taskENTER_CRITICAL(&lock);
+  TaskWorker *worker = task->worker;
+  task->worker = nullptr;
+  taskEXIT_CRITICAL(&lock);
+  if (!worker) {
+    return false;
+  }
+
+  if (xTaskGetCurrentTaskHandle() == worker->handle) {
+    vSemaphoreDelete(worker->idle);
+    delete worker;
+    deletedWorkers.fetch_add(1, std::memory_order_relaxed);
+    vTaskDelete(nullptr);
+  }
+
+  task->wake();
+  if (xSemaphoreTake(worker->idle, pdMS_TO_TICKS(LP_TASK_STOP_TIMEOUT_MS)) ==
+      pdTRUE) {
+    return true;
+  }
+
+  Task *job = task;
+  if (worker->job.compare_exchange_strong(job, nullptr)) {
+    log_w("Task \"%s\" did not stop within %u ms, deleting its worker",
+          task->getName(), (unsigned)LP_TASK_STOP_TIMEOUT_MS);
+    TaskStacks::deleteTask(worker->handle);
+    vSemaphoreDelete(worker->idle);
+    delete worker;
+    deletedWorkers.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    // run() returned just now and is about to signal
+    xSemaphoreTake(worker->idle, portMAX_DELAY);
+  }
+  return true;
+}
+
+void TaskWorkers::workerTask(void *parameter) {
+  TaskWorker *worker = static_cast<TaskWorker *>(parameter);
+
+  while (true) {
+    // Notifications meant for the previous task can arrive here too
+    while (!worker->job.load()) {
+      ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+
+    Task *job = worker->job.load();
+    job->run();
+    if (!worker->job.compare_exchange_strong(job, nullptr)) {
+      // stop() gave up waiting and is deleting this task
+      vTaskSuspend(nullptr);
+    }
+
+    // Without a stop() the task still points here: let go of it, so it
+    // reads as stopped and a later stop() has nothing to wait for. This is
+    // the worker's last access to the task.
+    bool stopping = true;
+    taskENTER_CRITICAL(&lock);
+    if (job->worker == worker) {
+      job->worker = nullptr;
+      job->taskHandle = nullptr;
+      job->state = TaskState::Stopped;
+      stopping = false;
+    }
+    taskEXIT_CRITICAL(&lock);
+    if (stopping) {
+      xSemaphoreGive(worker->idle);
+    }
+
+    if (!park(worker)) {
+      break;
+    }
+  }
+
+  vSemaphoreDelete(worker->idle);
+  delete worker;
+  deletedWorkers.fetch_add(1, std::memory_order_relaxed);
+  vTaskDelete(nullptr);
+}
+
+bool TaskWorkers::park(TaskWorker *worker) {
+  bool kept = false;
+
+  taskENTER_CRITICAL(&lock);
+  if (parkedCount < maxParked) {
+    worker->next = parked;
+    parked = worker;
+    parkedCount++;
+    kept = true;
+  }
+  taskEXIT_CRITICAL(&lock);
+
+  return kept;
+}
+
+TaskWorkers::Stats TaskWorkers::getStats() {
+  Stats stats;
+  taskENTER_CRITICAL(&lock);
+  stats.parked = parkedCount;
+  taskEXIT_CRITICAL(&lock);
+  stats.created = createdWorkers.load(std::memory_order_relaxed);
+  stats.reused = reusedWorkers.load(std::memory_order_relaxed);
+  stats.deleted = deletedWorkers.load(std::memory_order_relaxed);
+  return stats;
+}
+
+// ===== RecycledBlocks =====
+
+void *RecycledBlocks::take(size_t bytes) {
+  Block *block;
+
+  taskENTER_CRITICAL(&lock);
+  block = head;
+  if (block) {
+    head = block->next;
+    count--;
+  }
+  taskEXIT_CRITICAL(&lock);
+
+  return block ? block : ::operator new(bytes);
+}
+
+void RecycledBlocks::give(void *p) {
+  bool kept = false;
+
+  taskENTER_CRITICAL(&lock);
+  if (count < maxBlocks) {
+    Block *block = static_cast<Block *>(p);
+    block->next = head;
+    head = block;
+    count++;
+    kept = true;
+  }
+  taskEXIT_CRITICAL(&lock);
+
+  if (!kept) {
+    ::operator delete(p);
+  }
+}
+
+} // namespace ESPLooper
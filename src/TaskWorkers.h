@@ -0,0 +1,109 @@
+#pragma once
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <atomic>
+#include <new>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace ESPLooper {
+
+class Task;
+struct TaskWorker;
+
+// FreeRTOS tasks that run Task::run() and outlive the Task.
+//
+// With recycling enabled (LooperConfig::parkedWorkers), Task::start() hands
+// the task to a parked worker with the same stack size and core instead of
+// creating a FreeRTOS task, and Task::stop() ends run() cooperatively and
+// parks the worker instead of deleting it. Add/remove cycles then cost a
+// notification each way rather than a task creation and deletion. A reused
+// worker is renamed after its new task.
+class TaskWorkers {
+public:
+    // Keep up to `maxParked` idle workers (0 = delete them, the default)
+    static void configure(size_t maxParked);
+    static bool isEnabled();
+
+    // Run task->run() on a parked or new worker. The task's handle and
+    // state are set before run() starts. When run() returns without
+    // stop(), the worker lets go of the task: its handle and worker are
+    // cleared and it reads as stopped.
+    static bool start(Task* task);
+
+    // Make task->run() return and wait for it (up to LP_TASK_STOP_TIMEOUT_MS,
+    // then the worker is deleted mid-callback), then park the worker. From
+    // the task's own callback this deletes the worker instead, never
+    // returning - like vTaskDelete() on the calling task. False when run()
+    // had already returned on its own and there was nothing to stop.
+    static bool stop(Task* task);
+
+    struct Stats {
+        size_t parked;
+        uint32_t created;  // Workers started because none was parked
+        uint32_t reused;   // Tasks started on a parked worker
+        uint32_t deleted;  // Workers ended because the pool was full
+    };
+    static Stats getStats();
+
+private:
+    static void workerTask(void* parameter);
+    static bool park(TaskWorker* worker);
+};
+
+// Free list behind the recycling allocator: blocks of one size, kept up to
+// a shared limit (LooperConfig::recycledTasks)
+class RecycledBlocks {
+public:
+    static void setLimit(size_t limit) { maxBlocks = limit; }
+
+    void* take(size_t bytes);
+    void give(void* block);
+
+    size_t size() const { return count; }
+
+private:
+    struct Block {
+        Block* next;
+    };
+
+    static inline size_t maxBlocks = 0;
+
+    portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+    Block* head = nullptr;
+    size_t count = 0;
+};
+
+template <typename Key>
+inline RecycledBlocks recycledBlocks;
+
+// Allocator for the tasks Looper creates. allocate_shared() rebinds it to
+// the shared_ptr control block but keeps Key, so each task type gets a
+// free list of exactly-sized blocks: removing a task returns its block
+// there, and the next task of that type reuses it without the heap.
+template <typename T, typename Key = T>
+class RecyclingAllocator {
+public:
+    using value_type = T;
+
+    RecyclingAllocator() = default;
+    template <typename U>
+    RecyclingAllocator(const RecyclingAllocator<U, Key>&) {}
+
+    T* allocate(size_t n) { return static_cast<T*>(blocks().take(n * sizeof(T))); }
+    void deallocate(T* p, size_t) { blocks().give(p); }
+
+    template <typename U>
+    bool operator==(const RecyclingAllocator<U, Key>&) const { return true; }
+    template <typename U>
+    bool operator!=(const RecyclingAllocator<U, Key>&) const { return false; }
+
+    // Blocks waiting for the next task of type Key
+    static size_t recycled() { return blocks().size(); }
+
+private:
+    static RecycledBlocks& blocks() { return recycledBlocks<Key>; }
+};
+
+} // namespace ESPLooper
@@ -0,0 +1,153 @@
+#include "TimerService.h"
+#include "Task.h"
+
+namespace ESPLooper {
+
+static constexpr size_t SERVICE_COUNT = portNUM_PROCESSORS + 1;
+static TimerService *services[SERVICE_COUNT] = {};
+
+TimerService::TimerService()
+    : wheel(xTaskGetTickCount()), lock(portMUX_INITIALIZER_UNLOCKED),
+      handle(nullptr), running(nullptr), fired(0), wakeups(0),
+      maxLateness(0) {}
+
+bool TimerService::createServices(UBaseType_t priority, uint32_t stackSize) {
+  for (size_t i = 0; i < SERVICE_COUNT; i++) {
+    if (services[i]) {
+      continue;
+    }
+
+    TimerService *service = new TimerService();
+    BaseType_t result;
+    if (i < portNUM_PROCESSORS) {
+      result = xTaskCreatePinnedToCore(serviceTask, "TimerService", stackSize,
+                                       service, priority, &service->handle, i);
+    } else {
+      result = xTaskCreate(serviceTask, "TimerService", stackSize, service,
+                           priority, &service->handle);
+    }
+
+    if (result != pdPASS) {
+      delete service;
+      return false;
+    }
+    services[i] = service;
+  }
+  return true;
+}
+
+TimerService *TimerService::forCore(BaseType_t coreId) {
+  if (coreId >= 0 && coreId < portNUM_PROCESSORS) {
+    return services[coreId];
+  }
+  return services[portNUM_PROCESSORS];
+}
+
+void TimerService::schedule(TimerTask *timer, TickType_t delay) {
+  TimerNode &node = timer->wheelNode;
+
+  portENTER_CRITICAL(&lock);
+  if (node.pprev) {
+    wheel.unlink(&node);
+  }
+  node.owner = timer;
+  node.expiry = xTaskGetTickCount() + delay;
+  node.armed = true;
+  wheel.insert(&node);
+  portEXIT_CRITICAL(&lock);
+
+  // The service may be asleep past the new expiry
+  if (xTaskGetCurrentTaskHandle() != handle) {
+    xTaskNotifyGive(handle);
+  }
+}
+
+void TimerService::cancel(TimerTask *timer) {
+  TimerNode &node = timer->wheelNode;
+
+  portENTER_CRITICAL(&lock);
+  node.armed = false;
+  if (node.pprev) {
+    wheel.unlink(&node);
+  }
+  portEXIT_CRITICAL(&lock);
+
+  // The caller may free the timer next - don't let the callback outlive it
+  if (xTaskGetCurrentTaskHandle() != handle) {
+    while (running == timer) {
+      vTaskDelay(1);
+    }
+  }
+}
+
+void TimerService::serviceLoop() {
+  while (true) {
+    TickType_t now = xTaskGetTickCount();
+
+    portENTER_CRITICAL(&lock);
+    TimerNode *node;
+    while ((node = wheel.popExpired(now))) {
+      TimerTask *timer = node->owner;
+      TickType_t late = now - node->expiry;
+      if (late > maxLateness) {
+        maxLateness = late;
+      }
+      running = timer;
+      portEXIT_CRITICAL(&lock);
+
+      // cancel() from another task waits while `running` is this timer, so
+      // it is still here to pin. The pin keeps it alive when the callback
+      // removes its own timer (cancel() doesn't wait on this task).
+      std::shared_ptr<Task> self;
+      bool alive = timer->pin(self);
+      if (alive) {
+        timer->fire();
+      }
+
+      portENTER_CRITICAL(&lock);
+      running = nullptr;
+      fired++;
+
+      // Fixed rate like vTaskDelayUntil; periods missed while overrunning
+      // are skipped. Not re-armed if cancelled, and left alone if the
+      // callback rescheduled it (setPeriod). A timer being destroyed is
+      // left alone too - its destructor unlinks it.
+      if (alive && node->armed && !node->pprev) {
+        TickType_t period = timer->periodTicks();
+        node->expiry += period;
+        if (static_cast<int32_t>(node->expiry - now) <= 0) {
+          node->expiry = now + period;
+        }
+        wheel.insert(node);
+      }
+
+      // Dropping the last reference runs the destructor, which takes the
+      // lock to cancel
+      if (self) {
+        portEXIT_CRITICAL(&lock);
+        self.reset();
+        portENTER_CRITICAL(&lock);
+      }
+    }
+    TickType_t sleep = wheel.ticksUntilNext();
+    portEXIT_CRITICAL(&lock);
+
+    ulTaskNotifyTake(pdTRUE, sleep);
+    wakeups++;
+  }
+}
+
+void TimerService::serviceTask(void *parameter) {
+  static_cast<TimerService *>(parameter)->serviceLoop();
+}
+
+TimerService::Stats TimerService::getStats() const {
+  Stats stats;
+  stats.timers = wheel.size();
+  stats.fired = fired;
+  stats.wakeups = wakeups;
+  stats.maxLateness = maxLateness;
+  return stats;
+}
+
+} // namespace ESPLooper
@@ -0,0 +1,55 @@
+#pragma once
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <stdint.h>
+#include "TimerWheel.h"
+
+namespace ESPLooper {
+
+// Runs TimerTask callbacks from a hierarchical timing wheel (TimerWheel)
+// instead of one FreeRTOS task per timer (LooperConfig::timerMode =
+// TimerMode::Wheel).
+//
+// Insert and cancel are O(1) list operations under a spinlock. The wheel
+// gives the next expiry, so the service task sleeps in ulTaskNotifyTake()
+// until exactly then and a new or rescheduled timer wakes it early.
+class TimerService {
+public:
+    // Services are created by Looper::begin(): one pinned to each core plus
+    // one unpinned (index CORE_COUNT) for timers without affinity
+    static bool createServices(UBaseType_t priority, uint32_t stackSize);
+    static TimerService* forCore(BaseType_t coreId);
+
+    // (Re)schedule `timer` to fire after `delay` ticks
+    void schedule(TimerTask* timer, TickType_t delay);
+
+    // Remove `timer` from the wheel. If its callback is running on the
+    // service task, waits for it to return (unless called from it).
+    void cancel(TimerTask* timer);
+
+    struct Stats {
+        size_t timers;          // Timers on the wheel
+        uint32_t fired;         // Callbacks run
+        uint32_t wakeups;       // Times the service task woke up
+        TickType_t maxLateness; // Worst delay between expiry and callback
+    };
+    Stats getStats() const;
+    TaskHandle_t getHandle() const { return handle; }
+
+private:
+    TimerService();
+
+    TimerWheel wheel;             // Guarded by lock
+    portMUX_TYPE lock;
+    TaskHandle_t handle;
+    TimerTask* volatile running;  // Timer whose callback is executing
+    uint32_t fired;
+    uint32_t wakeups;
+    TickType_t maxLateness;
+
+    void serviceLoop();
+
+    static void serviceTask(void* parameter);
+};
+
+} // namespace ESPLooper
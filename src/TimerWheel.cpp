@@ -0,0 +1,129 @@
+#include "TimerWheel.h"
+
+namespace ESPLooper {
+
+static inline uint64_t rotateRight(uint64_t bits, unsigned shift) {
+  shift &= 63;
+  return shift ? (bits >> shift) | (bits << (64 - shift)) : bits;
+}
+
+TimerWheel::TimerWheel(TickType_t now)
+    : slots{}, occupied{}, wheelTime(now), count(0) {}
+
+void TimerWheel::insert(TimerNode *node) {
+  TickType_t delta = node->expiry - wheelTime;
+  if (static_cast<int32_t>(delta) < 0) {
+    // Already due: file it under the tick being processed
+    node->expiry = wheelTime;
+    delta = 0;
+  }
+
+  size_t level = 0;
+  TickType_t placed = node->expiry;
+  while (level < LEVELS - 1 && delta >= (TickType_t)1 << ((level + 1) * SLOT_BITS)) {
+    level++;
+  }
+  if (level == LEVELS - 1 && delta >= (TickType_t)1 << (LEVELS * SLOT_BITS)) {
+    // Beyond the wheel's range: park in the farthest slot, re-filed later
+    placed = wheelTime + ((TickType_t)1 << (LEVELS * SLOT_BITS)) - 1;
+  }
+
+  size_t slot = (placed >> (level * SLOT_BITS)) & (SLOTS - 1);
+  TimerNode **head = &slots[level][slot];
+  node->level = level;
+  node->slot = slot;
+  node->next = *head;
+  if (node->next) {
+    node->next->pprev = &node->next;
+  }
+  node->pprev = head;
+  *head = node;
+  occupied[level] |= 1ULL << slot;
+  count++;
+}
+
+void TimerWheel::unlink(TimerNode *node) {
+  *node->pprev = node->next;
+  if (node->next) {
+    node->next->pprev = node->pprev;
+  }
+  if (!slots[node->level][node->slot]) {
+    occupied[node->level] &= ~(1ULL << node->slot);
+  }
+  node->next = nullptr;
+  node->pprev = nullptr;
+  count--;
+}
+
+void TimerWheel::cascade(size_t level) {
+  size_t slot = (wheelTime >> (level * SLOT_BITS)) & (SLOTS - 1);
+  if (slot == 0 && level + 1 < LEVELS) {
+    cascade(level + 1);
+  }
+
+  // Move the slot's timers down now that they fall within a lower level
+  TimerNode *node = slots[level][slot];
+  slots[level][slot] = nullptr;
+  occupied[level] &= ~(1ULL << slot);
+  while (node) {
+    TimerNode *next = node->next;
+    count--;
+    insert(node);
+    node = next;
+  }
+}
+
+TimerNode *TimerWheel::popExpired(TickType_t now) {
+  while (true) {
+    size_t slot = wheelTime & (SLOTS - 1);
+    TimerNode *node = slots[0][slot];
+    if (node) {
+      unlink(node);
+      return node;
+    }
+    if (wheelTime == now) {
+      return nullptr;
+    }
+
+    // Nothing due in level 0: skip straight to the next cascade point
+    if (!occupied[0]) {
+      TickType_t blockEnd = wheelTime | (SLOTS - 1);
+      wheelTime =
+          static_cast<int32_t>(now - blockEnd) < 0 ? now : blockEnd;
+      if (wheelTime == now) {
+        return nullptr;
+      }
+    }
+
+    wheelTime++;
+    if ((wheelTime & (SLOTS - 1)) == 0) {
+      cascade(1);
+    }
+  }
+}
+
+TickType_t TimerWheel::ticksUntilNext() const {
+  // Level 0 holds exact expiries within the next SLOTS ticks
+  if (occupied[0]) {
+    unsigned from = (wheelTime + 1) & (SLOTS - 1);
+    return __builtin_ctzll(rotateRight(occupied[0], from)) + 1;
+  }
+
+  // Higher levels: sleep until the next occupied slot is cascaded
+  TickType_t best = portMAX_DELAY;
+  for (size_t level = 1; level < LEVELS; level++) {
+    if (!occupied[level]) {
+      continue;
+    }
+    unsigned shift = level * SLOT_BITS;
+    unsigned from = ((wheelTime >> shift) + 1) & (SLOTS - 1);
+    TickType_t blocks = __builtin_ctzll(rotateRight(occupied[level], from)) + 1;
+    TickType_t due = (((wheelTime >> shift) + blocks) << shift) - wheelTime;
+    if (due < best) {
+      best = due;
+    }
+  }
+  return best;
+}
+
+} // namespace ESPLooper
@@ -0,0 +1,61 @@
+#pragma once
+#include <freertos/FreeRTOS.h>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace ESPLooper {
+
+class TimerTask;
+
+// Intrusive wheel link embedded in every TimerTask
+struct TimerNode {
+    TimerNode* next = nullptr;
+    TimerNode** pprev = nullptr;  // Link pointing at this node; null = not queued
+    TimerTask* owner = nullptr;
+    TickType_t expiry = 0;
+    uint8_t level = 0;
+    uint8_t slot = 0;
+    bool armed = false;           // Re-armed after each callback while set
+};
+
+// Hierarchical timing wheel behind TimerService.
+//
+// Four levels of 64 slots cover 2^24 ticks; longer delays are parked in the
+// top level and re-filed when they come round. Insert and unlink are O(1)
+// list operations. Per-level occupancy bitmaps give the next expiry without
+// walking the slots. Not thread-safe: TimerService holds its lock around
+// every call.
+class TimerWheel {
+public:
+    static constexpr size_t LEVELS = 4;
+    static constexpr size_t SLOT_BITS = 6;
+    static constexpr size_t SLOTS = 1 << SLOT_BITS;
+
+    // `now` is the tick the wheel starts from
+    explicit TimerWheel(TickType_t now);
+
+    // File `node` under node->expiry; an expiry already passed fires on
+    // the next popExpired()
+    void insert(TimerNode* node);
+    void unlink(TimerNode* node);
+
+    // Advance the wheel up to `now` and return the next due node (already
+    // unlinked), or nullptr once nothing more is due
+    TimerNode* popExpired(TickType_t now);
+
+    // Ticks from the wheel's current time until the next node may become
+    // due (never later than the earliest expiry); portMAX_DELAY if empty
+    TickType_t ticksUntilNext() const;
+
+    size_t size() const { return count; }
+
+private:
+    TimerNode* slots[LEVELS][SLOTS];
+    uint64_t occupied[LEVELS];
+    TickType_t wheelTime;         // Last tick the wheel has processed
+    size_t count;
+
+    void cascade(size_t level);
+};
+
+} // namespace ESPLooper
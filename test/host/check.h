@@ -0,0 +1,20 @@
+// Minimal assertions for the host tests: each test binary returns non-zero
+// when any CHECK fails, which is all ctest needs
+#pragma once
+#include <stdio.h>
+#include <stdlib.h>
+
+static int checkFailures = 0;
+
+#define CHECK(cond)                                                          \
+    do {                                                                     \
+        if (!(cond)) {                                                       \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, \
+                    #cond);                                                  \
+            checkFailures++;                                                 \
+        }                                                                    \
+    } while (0)
+
+#define CHECK_EQ(a, b) CHECK((a) == (b))
+
+#define TEST_RESULT() (checkFailures == 0 ? EXIT_SUCCESS : EXIT_FAILURE)
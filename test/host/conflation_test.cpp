@@ -0,0 +1,136 @@
+#include "Conflation.h"
+#include "check.h"
+
+#include <atomic>
+#include <random>
+#include <thread>
+#include <vector>
+
+using ESPLooper::LastValueSlot;
+
+struct Value {
+    int id;
+};
+
+static void withdrawOwnValue() {
+    LastValueSlot<Value, 2> slot;
+    Value a{1};
+    CHECK(slot.offer(0, &a) == nullptr);
+    CHECK(!slot.drained());
+
+    int retries = 0;
+    Value* withdrawn = slot.withdraw(0, &a, [&] { retries++; return true; });
+    CHECK(withdrawn == &a);
+    CHECK_EQ(retries, 0);
+    CHECK(slot.drained());
+}
+
+// The race the withdraw path has to get right: our ticket failed, and a
+// newer sender replaced (and released) our value expecting that ticket
+static void newerValueIsNotStolen() {
+    LastValueSlot<Value, 2> slot;
+    Value ours{1};
+    Value newer{2};
+
+    CHECK(slot.offer(1, &ours) == nullptr);
+    CHECK(slot.offer(1, &newer) == &ours);
+
+    // A retried ticket now covers the newer value, which stays in place
+    int retries = 0;
+    CHECK(slot.withdraw(1, &ours, [&] { retries++; return true; }) == nullptr);
+    CHECK_EQ(retries, 1);
+    CHECK(slot.take(1) == &newer);
+    CHECK(slot.drained());
+
+    // Still no room: only then is the newest value withdrawn, so the slot
+    // is never left holding a value no ticket will deliver
+    CHECK(slot.offer(1, &ours) == nullptr);
+    CHECK(slot.offer(1, &newer) == &ours);
+    CHECK(slot.withdraw(1, &ours, [] { return false; }) == &newer);
+    CHECK(slot.drained());
+
+    // Other cores' values are independent
+    CHECK(slot.offer(0, &ours) == nullptr);
+    CHECK(slot.take(1) == nullptr);
+    CHECK(slot.take(0) == &ours);
+}
+
+// Senders race on one slot against a consumer popping tickets from a tiny
+// queue that often rejects them. Every value must end up exactly once as
+// delivered, replaced or withdrawn, and no value may be stranded.
+static void concurrentSenders() {
+    constexpr int SENDERS = 3;
+    constexpr int PER_SENDER = 50000;
+    constexpr int TICKET_LIMIT = 1;
+
+    LastValueSlot<Value, 1> slot;
+    std::vector<Value> values(SENDERS * PER_SENDER);
+    std::vector<std::atomic<int>> outcomes(values.size());
+    std::atomic<int> tickets{0};
+    std::atomic<bool> sending{true};
+
+    auto queueTicket = [&] {
+        int queued = tickets.load();
+        while (queued < TICKET_LIMIT) {
+            if (tickets.compare_exchange_weak(queued, queued + 1)) {
+                return true;
+            }
+        }
+        return false;
+    };
+    auto settle = [&](Value* value) { outcomes[value->id]++; };
+
+    std::thread consumer([&] {
+        while (sending.load() || tickets.load() > 0) {
+            if (tickets.load() == 0) {
+                std::this_thread::yield();
+                continue;
+            }
+            if (Value* value = slot.take(0)) {
+                settle(value);
+            }
+            tickets--;
+        }
+    });
+
+    std::vector<std::thread> senders;
+    for (int s = 0; s < SENDERS; s++) {
+        senders.emplace_back([&, s] {
+            std::minstd_rand random(s + 1);
+            for (int i = 0; i < PER_SENDER; i++) {
+                Value* value = &values[s * PER_SENDER + i];
+                value->id = s * PER_SENDER + i;
+                if (Value* stale = slot.offer(0, value)) {
+                    settle(stale);
+                    continue;
+                }
+                // Drop some tickets on purpose even when there is room
+                if (random() % 4 != 0 && queueTicket()) {
+                    continue;
+                }
+                if (Value* withdrawn = slot.withdraw(0, value, queueTicket)) {
+                    settle(withdrawn);
+                }
+            }
+        });
+    }
+    for (auto& sender : senders) {
+        sender.join();
+    }
+    sending = false;
+    consumer.join();
+
+    CHECK(slot.drained());
+    int wrong = 0;
+    for (auto& outcome : outcomes) {
+        wrong += outcome.load() != 1;
+    }
+    CHECK_EQ(wrong, 0);
+}
+
+int main() {
+    withdrawOwnValue();
+    newerValueIsNotStolen();
+    concurrentSenders();
+    return TEST_RESULT();
+}
@@ -0,0 +1,143 @@
+#include "IdTable.h"
+#include "check.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using ESPLooper::IdTable;
+
+struct Item {
+    explicit Item(uint32_t id) : id(id) {}
+    uint32_t id;
+};
+
+static void findInsertErase() {
+    IdTable<Item> table;
+    CHECK(!table.find(1));
+
+    auto a = std::make_shared<Item>(1);
+    auto b = std::make_shared<Item>(2);
+    CHECK(table.insert(1, a));
+    CHECK(table.insert(2, b));
+    CHECK(table.find(1) == a);
+    CHECK(table.find(2) == b);
+    CHECK(!table.find(3));
+
+    // Only the entry's own item removes it
+    CHECK(!table.erase(1, b.get()));
+    CHECK(table.erase(1, a.get()));
+    CHECK(!table.find(1));
+    CHECK(table.find(2) == b);
+    CHECK_EQ(table.getStats().entries, 1u);
+    CHECK_EQ(table.getStats().tombstones, 1u);
+}
+
+static void lastInsertWins() {
+    IdTable<Item> table;
+    auto first = std::make_shared<Item>(7);
+    auto second = std::make_shared<Item>(7);
+    CHECK(table.insert(7, first));
+
+    std::shared_ptr<Item> replaced;
+    CHECK(table.insert(7, second, &replaced));
+    CHECK(replaced == first);
+    CHECK(table.find(7) == second);
+    CHECK_EQ(table.getStats().entries, 1u);
+
+    // The replaced item no longer owns the ID
+    CHECK(!table.erase(7, first.get()));
+    CHECK(table.find(7) == second);
+}
+
+static void entriesDoNotKeepItemsAlive() {
+    IdTable<Item> table;
+    auto item = std::make_shared<Item>(5);
+    std::weak_ptr<Item> watch = item;
+    CHECK(table.insert(5, item));
+    item.reset();
+    CHECK(watch.expired());
+    CHECK(!table.find(5));
+}
+
+static void updatesAreInPlace() {
+    IdTable<Item> table;
+    CHECK(table.reserve(100));
+    uint32_t rebuilds = table.getStats().rebuilds;
+
+    std::vector<std::shared_ptr<Item>> items;
+    for (uint32_t id = 1; id <= 100; id++) {
+        items.push_back(std::make_shared<Item>(id));
+        CHECK(table.insert(id, items.back()));
+    }
+    CHECK_EQ(table.getStats().rebuilds, rebuilds);
+    CHECK_EQ(table.getStats().entries, 100u);
+
+    // Add/remove churn only rebuilds when tombstones fill the table, not
+    // once per update
+    for (uint32_t round = 0; round < 1000; round++) {
+        uint32_t id = 1000 + round;
+        auto extra = std::make_shared<Item>(id);
+        CHECK(table.insert(id, extra));
+        CHECK(table.erase(id, extra.get()));
+    }
+    CHECK(table.getStats().rebuilds - rebuilds < 20);
+    for (const auto& item : items) {
+        CHECK(table.find(item->id) == item);
+    }
+}
+
+static void readersDuringUpdates() {
+    IdTable<Item> table;
+    std::vector<std::shared_ptr<Item>> stable;
+    for (uint32_t id = 1; id <= 32; id++) {
+        stable.push_back(std::make_shared<Item>(id));
+        CHECK(table.insert(id, stable.back()));
+    }
+
+    std::atomic<bool> stop{false};
+    std::atomic<uint32_t> misses{0};
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 3; r++) {
+        readers.emplace_back([&] {
+            while (!stop.load()) {
+                for (const auto& item : stable) {
+                    std::shared_ptr<Item> found = table.find(item->id);
+                    if (found != item) {
+                        misses++;
+                    }
+                }
+            }
+        });
+    }
+
+    // Churn through enough entries to force rebuilds both ways
+    for (uint32_t round = 0; round < 200; round++) {
+        std::vector<std::shared_ptr<Item>> batch;
+        for (uint32_t i = 0; i < 64; i++) {
+            uint32_t id = 10000 + round * 64 + i;
+            batch.push_back(std::make_shared<Item>(id));
+            CHECK(table.insert(id, batch.back()));
+        }
+        for (const auto& item : batch) {
+            CHECK(table.erase(item->id, item.get()));
+        }
+    }
+
+    stop = true;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    CHECK_EQ(misses.load(), 0u);
+    CHECK(table.getStats().rebuilds > 0);
+}
+
+int main() {
+    findInsertErase();
+    lastInsertWins();
+    entriesDoNotKeepItemsAlive();
+    updatesAreInPlace();
+    readersDuringUpdates();
+    return TEST_RESULT();
+}
@@ -0,0 +1,146 @@
+#include "Pool.h"
+#include "check.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using ESPLooper::BlockPool;
+using ESPLooper::BufferRef;
+
+// Every block carries the id of the thread holding it. If the free list
+// ever handed one block to two threads (the ABA case the tag guards
+// against) the second owner would overwrite the first owner's mark.
+static void stressAcquireRelease() {
+    constexpr size_t BLOCKS = 8;
+    constexpr int THREADS = 4;
+    constexpr int ROUNDS = 200000;
+
+    BlockPool pool;
+    CHECK(pool.begin(sizeof(uint32_t), BLOCKS));
+
+    std::atomic<int> clashes{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; t++) {
+        threads.emplace_back([&, t] {
+            const uint32_t mark = 0xA0000000u | t;
+            void* held[2] = {nullptr, nullptr};
+            for (int i = 0; i < ROUNDS; i++) {
+                // Holding two blocks at a time interleaves pops and pushes
+                // of different indices, which is what exposes ABA
+                int n = i & 1;
+                if (held[n]) {
+                    if (*static_cast<volatile uint32_t*>(held[n]) != mark) {
+                        clashes++;
+                    }
+                    pool.release(held[n]);
+                    held[n] = nullptr;
+                }
+                void* block = pool.acquire();
+                if (!block) {
+                    continue;
+                }
+                *static_cast<volatile uint32_t*>(block) = mark;
+                std::this_thread::yield();
+                if (*static_cast<volatile uint32_t*>(block) != mark) {
+                    clashes++;
+                }
+                held[n] = block;
+            }
+            for (void* block : held) {
+                if (block) {
+                    pool.release(block);
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    CHECK_EQ(clashes.load(), 0);
+    CHECK_EQ(pool.getInUse(), 0u);
+
+    // Every block must be back on the free list exactly once
+    std::vector<void*> all;
+    while (void* block = pool.acquire()) {
+        for (void* seen : all) {
+            CHECK(seen != block);
+        }
+        all.push_back(block);
+    }
+    CHECK_EQ(all.size(), BLOCKS);
+}
+
+static void exhaustionAndOwnership() {
+    BlockPool pool;
+    CHECK(!pool.isEnabled());
+    CHECK(pool.acquire() == nullptr);
+    CHECK(!pool.begin(16, 0));
+
+    CHECK(pool.begin(10, 3));
+    CHECK(!pool.begin(10, 3));
+    CHECK_EQ(pool.getBlockSize() % alignof(max_align_t), 0u);
+
+    void* a = pool.acquire();
+    void* b = pool.acquire();
+    void* c = pool.acquire();
+    CHECK(a && b && c);
+    CHECK(pool.acquire() == nullptr);
+    CHECK_EQ(pool.getInUse(), 3u);
+
+    // Foreign pointers are ignored, not pushed onto the free list
+    int local = 0;
+    pool.release(&local);
+    pool.release(nullptr);
+    CHECK(!pool.owns(&local));
+    CHECK_EQ(pool.getInUse(), 3u);
+    CHECK(pool.acquire() == nullptr);
+
+    pool.release(b);
+    CHECK(pool.acquire() == b);
+    pool.release(a);
+    pool.release(b);
+    pool.release(c);
+    CHECK_EQ(pool.getInUse(), 0u);
+}
+
+static void externalStorage() {
+    alignas(max_align_t) static uint8_t storage[BlockPool::bytesFor(24, 4)];
+    BlockPool pool;
+    CHECK(pool.begin(24, 4, storage));
+    for (int i = 0; i < 4; i++) {
+        void* block = pool.acquire();
+        CHECK(block >= storage && block < storage + sizeof(storage));
+    }
+    CHECK(pool.acquire() == nullptr);
+}
+
+static void bufferRefSharing() {
+    BlockPool pool;
+    CHECK(pool.begin(BufferRef::blockSizeFor(32), 2));
+
+    BufferRef first = BufferRef::acquire(pool);
+    CHECK(first);
+    CHECK(first.capacity() >= 32);
+    {
+        BufferRef copy = first;
+        CHECK_EQ(first.useCount(), 2u);
+        CHECK(copy.data() == first.data());
+    }
+    CHECK_EQ(first.useCount(), 1u);
+
+    BufferRef moved = std::move(first);
+    CHECK(!first);
+    CHECK_EQ(pool.getInUse(), 1u);
+    moved.reset();
+    CHECK_EQ(pool.getInUse(), 0u);
+}
+
+int main() {
+    exhaustionAndOwnership();
+    externalStorage();
+    bufferRefSharing();
+    stressAcquireRelease();
+    return TEST_RESULT();
+}
@@ -0,0 +1,102 @@
+#include "RingBuffer.h"
+#include "check.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using ESPLooper::MpscRing;
+
+struct Item {
+    uint32_t producer;
+    uint32_t sequence;
+};
+
+static void capacityAndOrder() {
+    MpscRing<Item> ring;
+    CHECK(!ring.isEnabled());
+    CHECK(!ring.begin(0));
+    CHECK(ring.begin(5));
+    CHECK(!ring.begin(5));
+    CHECK_EQ(ring.capacity(), 8u);
+
+    Item items[9];
+    for (int i = 0; i < 8; i++) {
+        CHECK(ring.push(&items[i]));
+    }
+    CHECK(!ring.push(&items[8]));
+    CHECK_EQ(ring.size(), 8u);
+
+    Item* out = nullptr;
+    for (int i = 0; i < 8; i++) {
+        CHECK(ring.pop(out));
+        CHECK(out == &items[i]);
+    }
+    CHECK(!ring.pop(out));
+    CHECK_EQ(ring.size(), 0u);
+
+    // Wrap the indices around the cells several times
+    for (int round = 0; round < 100; round++) {
+        CHECK(ring.push(&items[round % 9]));
+        CHECK(ring.push(&items[(round + 1) % 9]));
+        CHECK(ring.pop(out) && out == &items[round % 9]);
+        CHECK(ring.pop(out) && out == &items[(round + 1) % 9]);
+    }
+}
+
+// Producers push increasing sequence numbers; the single consumer must see
+// every item exactly once and each producer's items in order
+static void concurrentProducers() {
+    constexpr int PRODUCERS = 4;
+    constexpr uint32_t PER_PRODUCER = 100000;
+
+    MpscRing<Item> ring;
+    CHECK(ring.begin(64));
+
+    std::vector<Item> items(PRODUCERS * PER_PRODUCER);
+    std::vector<std::thread> producers;
+    for (int p = 0; p < PRODUCERS; p++) {
+        producers.emplace_back([&, p] {
+            for (uint32_t i = 0; i < PER_PRODUCER; i++) {
+                Item* item = &items[p * PER_PRODUCER + i];
+                item->producer = p;
+                item->sequence = i;
+                while (!ring.push(item)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    uint32_t expected[PRODUCERS] = {};
+    uint32_t received = 0;
+    bool ordered = true;
+    while (received < PRODUCERS * PER_PRODUCER) {
+        Item* item;
+        if (!ring.pop(item)) {
+            std::this_thread::yield();
+            continue;
+        }
+        if (item->sequence != expected[item->producer]) {
+            ordered = false;
+        }
+        expected[item->producer] = item->sequence + 1;
+        received++;
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+
+    CHECK(ordered);
+    for (int p = 0; p < PRODUCERS; p++) {
+        CHECK_EQ(expected[p], PER_PRODUCER);
+    }
+    Item* extra;
+    CHECK(!ring.pop(extra));
+}
+
+int main() {
+    capacityAndOrder();
+    concurrentProducers();
+    return TEST_RESULT();
+}
@@ -0,0 +1,5 @@
+// Host stand-in for ESP-IDF's esp_attr.h: placement attributes are no-ops
+#pragma once
+
+#define IRAM_ATTR
+#define DRAM_ATTR
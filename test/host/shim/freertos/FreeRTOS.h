@@ -0,0 +1,12 @@
+// Host stand-in for the FreeRTOS base header: only the types and constants
+// the tested sources use
+#pragma once
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define portMAX_DELAY ((TickType_t)0xFFFFFFFFUL)
+#define pdTRUE 1
+#define pdFALSE 0
@@ -0,0 +1,129 @@
+#include "Snapshot.h"
+#include "check.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using ESPLooper::Snapshot;
+
+struct Table {
+    std::vector<uint32_t> values;
+    void clear() { values.clear(); }
+};
+
+static void pinnedVersionOutlivesPublish() {
+    Snapshot<Table> snapshot;
+    CHECK(snapshot.current().values.empty());
+
+    Table* first = snapshot.edit();
+    first->values.push_back(1);
+    snapshot.publish(first);
+
+    const Table* pinned = snapshot.acquire();
+    CHECK(pinned == first);
+
+    Table* second = snapshot.edit();
+    CHECK(second != first);
+    CHECK_EQ(second->values.size(), 1u);
+    second->values.push_back(2);
+    uint32_t epoch = snapshot.publish(second);
+
+    // The old version is still readable and unchanged while pinned
+    CHECK(!snapshot.collect(epoch));
+    CHECK_EQ(pinned->values.size(), 1u);
+    CHECK_EQ(snapshot.current().values.size(), 2u);
+
+    snapshot.release(pinned);
+    CHECK(snapshot.collect(epoch));
+
+    // Reclaimed versions come back emptied and are reused by edit()
+    Table* third = snapshot.edit();
+    CHECK(third == first);
+    CHECK_EQ(third->values.size(), 2u);
+    snapshot.discard(third);
+
+    Table* blank = snapshot.fresh();
+    CHECK(blank->values.empty());
+    snapshot.discard(blank);
+}
+
+static void laterReadersDoNotDelayCollect() {
+    Snapshot<Table> snapshot;
+    const Table* old = snapshot.acquire();
+    uint32_t epoch = snapshot.publish(snapshot.edit());
+
+    // Readers of the newer version don't count against the older epoch
+    const Table* fresh = snapshot.acquire();
+    CHECK(!snapshot.collect(epoch));
+    snapshot.release(old);
+    CHECK(snapshot.collect(epoch));
+
+    // A version retired after the epoch doesn't hold it up either
+    uint32_t later = snapshot.publish(snapshot.edit());
+    CHECK(snapshot.collect(epoch));
+    CHECK(!snapshot.collect(later));
+    snapshot.release(fresh);
+    CHECK(snapshot.collect(later));
+}
+
+// Readers check that every version they pin is internally consistent while
+// a writer keeps replacing it; after each publish the writer waits for the
+// old version, which must not be starved by readers of newer ones
+static void concurrentReadersAndWriter() {
+    constexpr int READERS = 3;
+    constexpr uint32_t PUBLISHES = 20000;
+
+    Snapshot<Table> snapshot;
+    std::atomic<bool> running{true};
+    std::atomic<int> torn{0};
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < READERS; r++) {
+        readers.emplace_back([&] {
+            while (running.load()) {
+                const Table* table = snapshot.acquire();
+                size_t size = table->values.size();
+                for (uint32_t value : table->values) {
+                    if (value != size) {
+                        torn++;
+                    }
+                }
+                snapshot.release(table);
+            }
+        });
+    }
+
+    bool starved = false;
+    for (uint32_t i = 1; i <= PUBLISHES && !starved; i++) {
+        Table* table = snapshot.edit();
+        size_t size = i % 17;
+        table->values.assign(size, size);
+        uint32_t epoch = snapshot.publish(table);
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+        while (!snapshot.collect(epoch)) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                starved = true;
+                break;
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    running = false;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    CHECK(!starved);
+    CHECK_EQ(torn.load(), 0);
+    CHECK(snapshot.collect(snapshot.epoch()));
+}
+
+int main() {
+    pinnedVersionOutlivesPublish();
+    laterReadersDoNotDelayCollect();
+    concurrentReadersAndWriter();
+    return TEST_RESULT();
+}
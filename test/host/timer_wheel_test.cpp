@@ -0,0 +1,116 @@
+#include "TimerWheel.h"
+#include "check.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using ESPLooper::TimerNode;
+using ESPLooper::TimerWheel;
+
+// Drive the wheel the way TimerService does: sleep ticksUntilNext(), then
+// pop everything due. Every node must fire exactly at its expiry (the
+// sleep never overshoots) and exactly once.
+static void runAndCheck(TimerWheel& wheel, TickType_t start,
+                        std::vector<TimerNode>& nodes, TickType_t horizon) {
+    std::vector<int> fired(nodes.size(), 0);
+    int early = 0;
+    int late = 0;
+
+    TickType_t now = start;
+    while (true) {
+        while (TimerNode* node = wheel.popExpired(now)) {
+            fired[node - nodes.data()]++;
+            early += static_cast<int32_t>(node->expiry - now) > 0;
+            late += static_cast<int32_t>(now - node->expiry) > 0;
+        }
+        if (wheel.size() == 0 || now - start >= horizon) {
+            break;
+        }
+        TickType_t sleep = wheel.ticksUntilNext();
+        CHECK(sleep > 0);
+        now += std::min<TickType_t>(sleep, horizon);
+    }
+
+    CHECK_EQ(wheel.size(), 0u);
+    CHECK_EQ(early, 0);
+    CHECK_EQ(late, 0);
+    CHECK(std::all_of(fired.begin(), fired.end(), [](int n) { return n == 1; }));
+}
+
+static void cascadesAcrossLevels(TickType_t start) {
+    // Edges of every level, plus delays beyond the wheel's 2^24 tick range
+    const TickType_t delays[] = {
+        0, 1, 2, 63, 64, 65, 127, 128, 4095, 4096, 4097, 262143, 262144,
+        262145, (1u << 24) - 1, 1u << 24, (1u << 24) + 1, (1u << 25) + 12345,
+        (1u << 31) - 1,
+    };
+    TimerWheel wheel(start);
+    std::vector<TimerNode> nodes(sizeof(delays) / sizeof(delays[0]));
+    for (size_t i = 0; i < nodes.size(); i++) {
+        nodes[i].expiry = start + delays[i];
+        wheel.insert(&nodes[i]);
+    }
+    CHECK_EQ(wheel.size(), nodes.size());
+    runAndCheck(wheel, start, nodes, 1u << 31);
+}
+
+static void randomTimers(TickType_t start, uint32_t seed) {
+    std::minstd_rand random(seed);
+    TimerWheel wheel(start);
+    std::vector<TimerNode> nodes(500);
+    for (auto& node : nodes) {
+        // Mostly short, some long delays
+        TickType_t delay = random() % 4 == 0 ? random() % (1u << 26)
+                                             : random() % 5000;
+        node.expiry = start + delay;
+        wheel.insert(&node);
+    }
+    runAndCheck(wheel, start, nodes, 1u << 27);
+}
+
+static void unlinkAndLateInsert() {
+    TimerWheel wheel(100);
+    TimerNode a, b, c;
+    a.expiry = 150;
+    b.expiry = 150;
+    c.expiry = 10000;
+    wheel.insert(&a);
+    wheel.insert(&b);
+    wheel.insert(&c);
+
+    wheel.unlink(&a);
+    CHECK(a.pprev == nullptr);
+    CHECK_EQ(wheel.size(), 2u);
+
+    CHECK(wheel.popExpired(149) == nullptr);
+    CHECK(wheel.popExpired(150) == &b);
+    CHECK(wheel.popExpired(150) == nullptr);
+
+    // An expiry already in the past fires on the next pop
+    a.expiry = 10;
+    wheel.insert(&a);
+    CHECK(wheel.popExpired(150) == &a);
+
+    wheel.unlink(&c);
+    CHECK_EQ(wheel.size(), 0u);
+    CHECK_EQ(wheel.ticksUntilNext(), portMAX_DELAY);
+
+    // Sleeping past an occupied slot must not skip it
+    c.expiry = 500;
+    wheel.insert(&c);
+    CHECK(wheel.popExpired(100000) == &c);
+}
+
+int main() {
+    cascadesAcrossLevels(0);
+    cascadesAcrossLevels(12345);
+    // Tick counter wrapping around during the run
+    cascadesAcrossLevels(0xFFFFFF00u);
+    cascadesAcrossLevels(0xFFFFFFFFu - (1u << 20));
+    for (uint32_t seed = 1; seed <= 4; seed++) {
+        randomTimers(seed * 0x3FFFFFFFu, seed);
+    }
+    unlinkAndLateInsert();
+    return TEST_RESULT();
+}